@@ -0,0 +1,453 @@
+// Benchmark harness for compress and encrypt
+// Times the histogram, code construction, encode and decode stages over a corpus
+// (text, binary, random, skewed, plus any files given on the command line) and the AES
+// block function, and prints MB/s, cycles/byte, compression ratio and latency percentiles
+// as JSON on stdout.
+//   bench [-n iterations] [-s synthetic_mib] [file...]
+// Exits with 1 if any sample fails to round-trip.
+#define _POSIX_C_SOURCE 200809L   // clock_gettime con -std=c11
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#else
+#define BENCH_HAVE_TSC 0
+#endif
+
+#include "huffman.h"
+#include "histogram.h"
+#include "bitwriter.h"
+#include "compress.h"
+#include "decompress.h"
+#include "io.h"
+#include "aes.h"
+#include "ctr.h"
+
+#define BENCH_DEFAULT_ITERATIONS 25
+#define BENCH_DEFAULT_SYNTHETIC_MIB 4
+// Texto del corpus: se descomprime al arrancar. El Makefile pasa la ruta absoluta para que no
+// dependa del directorio desde el que se lanza el binario.
+#ifndef BENCH_TEXT_PATH
+#define BENCH_TEXT_PATH "../compress/bible.huf"
+#endif
+#define BENCH_AES_BYTES (1 << 20)
+#define BENCH_MAX_SAMPLES 32
+
+typedef struct Sample {
+    const char *name;
+    unsigned char *data;
+    size_t size;
+} Sample;
+
+// Estado compartido por las etapas de una muestra; cada etapa deja su resultado para la siguiente.
+typedef struct BenchCtx {
+    const unsigned char *in;
+    size_t n;
+    uint64_t f_s[256];
+    Code codes[256];
+    unsigned char *enc;
+    size_t enc_cap;
+    size_t enc_size;
+    DecodeTable *table;
+    unsigned char *dec;
+    int decode_rc;
+    aes_ctx aes;
+    unsigned char *aes_in;
+    unsigned char *aes_out;
+} BenchCtx;
+
+typedef void (*StageFn)(BenchCtx *ctx);
+
+typedef struct StageResult {
+    const char *name;
+    size_t bytes;            // bytes procesados por iteración (0: trabajo de tamaño fijo)
+    int iterations;
+    double p50_ns, p90_ns, p99_ns, min_ns;
+    double cycles_p50;       // ciclos de TSC de la iteración mediana
+} StageResult;
+
+static double nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint64_t readCycles(void) {
+#if BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static uint64_t nextRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+static int compareDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil por rango más cercano sobre valores ya ordenados.
+static double percentile(const double *sorted, int n, double p) {
+    int k = (int)(p * n + 0.999999) - 1;
+    if (k < 0) { k = 0; }
+    if (k >= n) { k = n - 1; }
+    return sorted[k];
+}
+
+static void measure(StageResult *r, const char *name, StageFn fn, BenchCtx *ctx, size_t bytes,
+                    int iterations, double *ns, double *cycles) {
+    fn(ctx);   // calentamiento: caches, páginas y predictores
+    for (int i = 0; i < iterations; i++) {
+        double t0 = nowNs();
+        uint64_t c0 = readCycles();
+        fn(ctx);
+        uint64_t c1 = readCycles();
+        ns[i] = nowNs() - t0;
+        cycles[i] = (double)(c1 - c0);
+    }
+    qsort(ns, (size_t)iterations, sizeof *ns, compareDouble);
+    qsort(cycles, (size_t)iterations, sizeof *cycles, compareDouble);
+
+    r->name = name;
+    r->bytes = bytes;
+    r->iterations = iterations;
+    r->p50_ns = percentile(ns, iterations, 0.50);
+    r->p90_ns = percentile(ns, iterations, 0.90);
+    r->p99_ns = percentile(ns, iterations, 0.99);
+    r->min_ns = ns[0];
+    r->cycles_p50 = percentile(cycles, iterations, 0.50);
+}
+
+static void stageHistogram(BenchCtx *ctx) {
+    histogramCount(ctx->in, ctx->n, ctx->f_s);
+}
+
+static void stageBuild(BenchCtx *ctx) {
+    huffmanBuildCodes(ctx->f_s, ctx->codes);
+}
+
+static void stageEncode(BenchCtx *ctx) {
+    BitWriter bw;
+    bitWriterInitBuffer(&bw, ctx->enc, ctx->enc_cap);
+    for (size_t i = 0; i < ctx->n; i++) {
+        Code code = ctx->codes[ctx->in[i]];
+        bitWriterWrite(&bw, code.bits, (int)code.length);
+    }
+    bitWriterFlush(&bw);
+    ctx->enc_size = bw.out_pos;
+}
+
+static void stageDecode(BenchCtx *ctx) {
+    ctx->decode_rc = huffmanDecode(ctx->table, ctx->enc, ctx->enc_size, ctx->dec, ctx->n);
+}
+
+static void stageAes(BenchCtx *ctx) {
+    for (size_t i = 0; i < BENCH_AES_BYTES; i += 16) {
+        aes_encrypt_block(ctx->aes_in + i, ctx->aes_out + i, (const word *)ctx->aes.enc_key);
+    }
+}
+
+// CTR en un solo hilo sobre el buffer de salida (AES_INTERLEAVE bloques por iteración).
+static void stageAesCtr(BenchCtx *ctx) {
+    static const uint8_t nonce[CTR_NONCE_SIZE] = {0};
+    aes_ctr_xor(&ctx->aes, nonce, 0, ctx->aes_out, BENCH_AES_BYTES);
+}
+
+// Descifrado ECB con el esquema inverso ya expandido en el contexto.
+static void stageAesDecrypt(BenchCtx *ctx) {
+    aes_ctx_decrypt(&ctx->aes, ctx->aes_in, ctx->aes_out, BENCH_AES_BYTES / 16);
+}
+
+static void printStage(const StageResult *r, int last) {
+    printf("        {\"stage\": \"%s\", \"bytes\": %zu, \"iterations\": %d, ", r->name, r->bytes, r->iterations);
+    if (r->bytes > 0) {
+        printf("\"mb_s\": %.1f, ", (double)r->bytes / (r->p50_ns / 1e9) / 1e6);
+        if (BENCH_HAVE_TSC) {
+            printf("\"cycles_per_byte\": %.3f, ", r->cycles_p50 / (double)r->bytes);
+        } else {
+            printf("\"cycles_per_byte\": null, ");
+        }
+    } else {
+        printf("\"mb_s\": null, \"cycles_per_byte\": null, ");
+    }
+    printf("\"min_us\": %.3f, \"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f}%s\n",
+           r->min_ns / 1e3, r->p50_ns / 1e3, r->p90_ns / 1e3, r->p99_ns / 1e3, last ? "" : ",");
+}
+
+// Nombre como cadena JSON: las rutas pueden traer comillas o barras invertidas.
+static void printJsonString(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            printf("\\%c", c);
+        } else if (c < 0x20) {
+            printf("\\u%04x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+// Texto: bible.huf del repositorio; si no está, palabras frecuentes con reparto sesgado.
+static int makeText(Sample *s, size_t size, uint64_t *rng) {
+    MappedFile mf;
+    if (mapFile(BENCH_TEXT_PATH, &mf) == 0) {
+        int rc = decompressBuffer(mf.data, mf.size, &s->data, &s->size);
+        unmapFile(&mf);
+        if (rc == 0) {
+            s->name = "text";
+            return 0;
+        }
+    }
+
+    static const char *const words[] = {
+        "the", "and", "of", "to", "that", "in", "he", "shall", "unto", "for", "i", "his", "a",
+        "lord", "they", "be", "is", "him", "not", "them", "it", "with", "all", "thou", "thy",
+    };
+    const size_t nwords = sizeof words / sizeof words[0];
+    s->name = "text";
+    s->size = size;
+    s->data = malloc(size);
+    if (!s->data) { return -1; }
+    size_t pos = 0, line = 0;
+    while (pos < size) {
+        // Mínimo de dos sorteos: las primeras palabras salen mucho más.
+        size_t a = nextRandom(rng) % nwords, b = nextRandom(rng) % nwords;
+        const char *w = words[a < b ? a : b];
+        for (; *w && pos < size; w++) { s->data[pos++] = (unsigned char)*w; }
+        if (pos < size) { s->data[pos++] = (++line % 12 == 0) ? '\n' : ' '; }
+    }
+    return 0;
+}
+
+// Binario: registros de 16 bytes (id creciente, tipo, flags, valor en paseo aleatorio).
+static int makeBinary(Sample *s, size_t size, uint64_t *rng) {
+    s->name = "binary";
+    s->size = size;
+    s->data = malloc(size);
+    if (!s->data) { return -1; }
+    uint32_t id = 1000;
+    int64_t value = 1 << 20;
+    for (size_t pos = 0; pos < size; pos += 16) {
+        unsigned char rec[16];
+        uint16_t type = (uint16_t)(nextRandom(rng) % 8);
+        uint16_t flags = (uint16_t)((nextRandom(rng) % 16) == 0 ? 0x8001 : 0x0001);
+        value += (int64_t)(nextRandom(rng) % 2001) - 1000;
+        id += 1 + (uint32_t)(nextRandom(rng) % 3);
+        memcpy(rec, &id, 4);
+        memcpy(rec + 4, &type, 2);
+        memcpy(rec + 6, &flags, 2);
+        memcpy(rec + 8, &value, 8);
+        memcpy(s->data + pos, rec, size - pos < 16 ? size - pos : 16);
+    }
+    return 0;
+}
+
+static int makeRandom(Sample *s, size_t size, uint64_t *rng) {
+    s->name = "random";
+    s->size = size;
+    s->data = malloc(size);
+    if (!s->data) { return -1; }
+    for (size_t pos = 0; pos < size; pos++) { s->data[pos] = (unsigned char)(nextRandom(rng) >> 7); }
+    return 0;
+}
+
+// Sesgado: distribución geométrica, P(k) = 2^-(k+1); cerca de 2 bits por byte.
+static int makeSkewed(Sample *s, size_t size, uint64_t *rng) {
+    s->name = "skewed";
+    s->size = size;
+    s->data = malloc(size);
+    if (!s->data) { return -1; }
+    for (size_t pos = 0; pos < size; pos++) {
+        uint64_t r = nextRandom(rng);
+        unsigned char k = 0;
+        while (k < 30 && (r & 1)) { r >>= 1; k++; }
+        s->data[pos] = k;
+    }
+    return 0;
+}
+
+// Corre las cuatro etapas sobre una muestra e imprime su objeto JSON.
+// Returns: 0 if the sample round-trips, -1 otherwise
+static int benchSample(const Sample *s, int iterations, double *ns, double *cycles, int last) {
+    BenchCtx ctx;
+    memset(&ctx, 0, sizeof ctx);
+    ctx.in = s->data;
+    ctx.n = s->size;
+
+    histogramCount(ctx.in, ctx.n, ctx.f_s);
+    huffmanBuildCodes(ctx.f_s, ctx.codes);
+    ctx.enc_cap = (size_t)((huffmanEncodedBits(ctx.f_s, ctx.codes) + 7) / 8) + 16;
+    ctx.enc = malloc(ctx.enc_cap);
+    ctx.dec = malloc(ctx.n ? ctx.n : 1);
+    ctx.table = malloc(sizeof *ctx.table);
+    if (!ctx.enc || !ctx.dec || !ctx.table) {
+        free(ctx.enc);
+        free(ctx.dec);
+        free(ctx.table);
+        return -1;
+    }
+
+    StageResult r[4];
+    measure(&r[0], "histogram", stageHistogram, &ctx, ctx.n, iterations, ns, cycles);
+    measure(&r[1], "build", stageBuild, &ctx, 0, iterations, ns, cycles);
+    measure(&r[2], "encode", stageEncode, &ctx, ctx.n, iterations, ns, cycles);
+
+    unsigned char lens[256];
+    for (int i = 0; i < 256; i++) { lens[i] = (unsigned char)ctx.codes[i].length; }
+    int ok = 1, nstages = 3;
+    if (ctx.n > 0) {
+        ok = buildDecodeTable(ctx.table, lens) == 0;
+        if (ok) {
+            measure(&r[3], "decode", stageDecode, &ctx, ctx.n, iterations, ns, cycles);
+            ok = ctx.decode_rc == 0 && memcmp(ctx.dec, ctx.in, ctx.n) == 0;
+            nstages = 4;
+        }
+    }
+
+    size_t compressed = HUF1_HEADER_SIZE + ctx.enc_size;
+    printf("    {\"name\": ");
+    printJsonString(s->name);
+    printf(", \"bytes\": %zu, \"compressed_bytes\": %zu, \"ratio\": %.4f, \"round_trip\": %s,\n",
+           s->size, compressed, (double)s->size / (double)compressed, ok ? "true" : "false");
+    printf("      \"stages\": [\n");
+    for (int i = 0; i < nstages; i++) { printStage(&r[i], i == nstages - 1); }
+    printf("      ]}%s\n", last ? "" : ",");
+
+    free(ctx.enc);
+    free(ctx.dec);
+    free(ctx.table);
+    return ok ? 0 : -1;
+}
+
+// Bloque AES sobre BENCH_AES_BYTES con el vector de clave de FIPS-197.
+static int benchAes(int iterations, double *ns, double *cycles) {
+    static const uint8_t key[16] = {
+        0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+    };
+    static const uint8_t plaintext[16] = {
+        0x32, 0x43, 0xf6, 0xa8, 0x88, 0x5a, 0x30, 0x8d, 0x31, 0x31, 0x98, 0xa2, 0xe0, 0x37, 0x07, 0x34
+    };
+    static const uint8_t expected[16] = {
+        0x39, 0x25, 0x84, 0x1d, 0x02, 0xdc, 0x09, 0xfb, 0xdc, 0x11, 0x85, 0x97, 0x19, 0x6a, 0x0b, 0x32
+    };
+
+    BenchCtx ctx;
+    memset(&ctx, 0, sizeof ctx);
+    aes_ctx_init(&ctx.aes, key);
+    ctx.aes_in = malloc(BENCH_AES_BYTES);
+    ctx.aes_out = malloc(BENCH_AES_BYTES);
+    if (!ctx.aes_in || !ctx.aes_out) {
+        free(ctx.aes_in);
+        free(ctx.aes_out);
+        return -1;
+    }
+    for (size_t i = 0; i < BENCH_AES_BYTES; i += 16) { memcpy(ctx.aes_in + i, plaintext, 16); }
+
+    StageResult r, per_backend[6];
+    measure(&r, "aes_encrypt_block", stageAes, &ctx, BENCH_AES_BYTES, iterations, ns, cycles);
+    int ok = memcmp(ctx.aes_out, expected, 16) == 0;
+
+    // CTR y descifrado con cada backend disponible; el último es el que elige AES_BACKEND_AUTO.
+    // El backend queda fijo al crear el contexto, así que se vuelve a crear para cada uno.
+    static const struct { aes_backend_t backend; const char *ctr_name, *decrypt_name; } backends[] = {
+        {AES_BACKEND_TABLE, "aes_ctr_xor_table", "aes_ctx_decrypt_table"},
+        {AES_BACKEND_BITSLICE, "aes_ctr_xor_bitslice", "aes_ctx_decrypt_bitslice"},
+        {AES_BACKEND_AUTO, "aes_ctr_xor", "aes_ctx_decrypt"},
+    };
+    int nstages = 0;
+    for (int i = 0; i < 3; i++) {
+        if (aes_set_backend(backends[i].backend) != AES_SUCCESS) { continue; }
+        aes_ctx_init(&ctx.aes, key);
+        uint8_t decrypted[16];
+        aes_ctx_decrypt(&ctx.aes, expected, decrypted, 1);
+        ok = ok && memcmp(decrypted, plaintext, 16) == 0;
+        measure(&per_backend[nstages++], backends[i].ctr_name, stageAesCtr, &ctx, BENCH_AES_BYTES, iterations, ns, cycles);
+        measure(&per_backend[nstages++], backends[i].decrypt_name, stageAesDecrypt, &ctx, BENCH_AES_BYTES,
+                iterations, ns, cycles);
+    }
+
+    printf("  \"aes\": {\"known_answer\": %s, \"stages\": [\n", ok ? "true" : "false");
+    printStage(&r, 0);
+    for (int i = 0; i < nstages; i++) { printStage(&per_backend[i], i == nstages - 1); }
+    printf("  ]}\n");
+
+    aes_ctx_clear(&ctx.aes);
+    free(ctx.aes_in);
+    free(ctx.aes_out);
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+    int iterations = BENCH_DEFAULT_ITERATIONS;
+    size_t synthetic = (size_t)BENCH_DEFAULT_SYNTHETIC_MIB << 20;
+    Sample samples[BENCH_MAX_SAMPLES];
+    int nsamples = 0;
+    uint64_t rng = 12345;
+
+    // Primero el corpus fijo, para que los resultados sean comparables entre corridas.
+    const char *files[BENCH_MAX_SAMPLES];
+    int nfiles = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            synthetic = (size_t)strtoull(argv[++i], NULL, 10) << 20;
+        } else if (argv[i][0] != '-' && nfiles < BENCH_MAX_SAMPLES - 4) {
+            files[nfiles++] = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [-n iterations] [-s synthetic_mib] [file...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 1) { iterations = 1; }
+    if (synthetic == 0) { synthetic = 1 << 20; }
+
+    if (makeText(&samples[nsamples++], synthetic, &rng) != 0 ||
+        makeBinary(&samples[nsamples++], synthetic, &rng) != 0 ||
+        makeRandom(&samples[nsamples++], synthetic, &rng) != 0 ||
+        makeSkewed(&samples[nsamples++], synthetic, &rng) != 0) {
+        fprintf(stderr, "Out of memory building the corpus.\n");
+        return 1;
+    }
+    for (int i = 0; i < nfiles; i++) {
+        Sample *s = &samples[nsamples];
+        s->name = files[i];
+        if (readFile(files[i], &s->data, &s->size) != 0) {
+            fprintf(stderr, "Error reading %s.\n", files[i]);
+            return 1;
+        }
+        nsamples++;
+    }
+
+    double *ns = malloc((size_t)iterations * sizeof *ns);
+    double *cycles = malloc((size_t)iterations * sizeof *cycles);
+    if (!ns || !cycles) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+
+    int failed = 0;
+    printf("{\n  \"iterations\": %d,\n  \"tsc\": %s,\n  \"corpus\": [\n", iterations, BENCH_HAVE_TSC ? "true" : "false");
+    for (int i = 0; i < nsamples; i++) {
+        if (benchSample(&samples[i], iterations, ns, cycles, i == nsamples - 1) != 0) { failed = 1; }
+    }
+    printf("  ],\n");
+    if (benchAes(iterations, ns, cycles) != 0) { failed = 1; }
+    printf("}\n");
+
+    for (int i = 0; i < nsamples; i++) { free(samples[i].data); }
+    free(ns);
+    free(cycles);
+    return failed;
+}
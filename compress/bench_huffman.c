@@ -0,0 +1,101 @@
+// Microbenchmark: huffmanAlgorithm (qsort + heap tree) vs huffmanBuildCodes (two-queue, stack only)
+// Also checks that both produce the same code lengths for every histogram.
+#define _POSIX_C_SOURCE 200809L   // clock_gettime con -std=c11
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "huffman.h"
+
+#define ITERATIONS 20000
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static uint64_t nextRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+static double timeTree(const uint64_t f_s[256], Code codes[256]) {
+    huffmanNode *activeNodes[256];
+    double start = nowSeconds();
+    for (int i = 0; i < ITERATIONS; i++) {
+        huffmanNode *root = huffmanAlgorithm(f_s, activeNodes, codes);
+        freeHuffmanTree(root);
+    }
+    return (nowSeconds() - start) / ITERATIONS * 1e9;
+}
+
+static double timeTwoQueue(const uint64_t f_s[256], Code codes[256]) {
+    double start = nowSeconds();
+    for (int i = 0; i < ITERATIONS; i++) {
+        huffmanBuildCodes(f_s, codes);
+    }
+    return (nowSeconds() - start) / ITERATIONS * 1e9;
+}
+
+static int sameLengths(const uint64_t f_s[256]) {
+    huffmanNode *activeNodes[256];
+    Code tree[256], flat[256];
+    memset(tree, 0, sizeof tree);
+    huffmanNode *root = huffmanAlgorithm(f_s, activeNodes, tree);
+    int single = root && root->symbol != -1;
+    freeHuffmanTree(root);
+    if (single) { return 1; }   // hoja sola: huffmanAlgorithm no llena codes
+    huffmanBuildCodes(f_s, flat);
+    for (int s = 0; s < 256; s++) {
+        if (tree[s].length != flat[s].length || tree[s].bits != flat[s].bits) { return 0; }
+    }
+    return 1;
+}
+
+static void run(const char *name, const uint64_t f_s[256]) {
+    Code codes[256];
+    double tree_ns = timeTree(f_s, codes);
+    double flat_ns = timeTwoQueue(f_s, codes);
+    printf("%-10s tree %9.0f ns  two-queue %7.0f ns  speedup %5.1fx  %s\n",
+           name, tree_ns, flat_ns, tree_ns / flat_ns, sameLengths(f_s) ? "same" : "DIFFERENT");
+}
+
+int main(int argc, char **argv) {
+    uint64_t f_s[256];
+    uint64_t rng = 12345;
+
+    // Texto: histograma de un archivo (por defecto bible.txt) si existe.
+    const char *path = argc > 1 ? argv[1] : "bible.txt";
+    FILE *fp = fopen(path, "rb");
+    if (fp) {
+        memset(f_s, 0, sizeof f_s);
+        int c;
+        while ((c = fgetc(fp)) != EOF) { f_s[c]++; }
+        fclose(fp);
+        run("text", f_s);
+    }
+
+    for (int s = 0; s < 256; s++) { f_s[s] = 1000 + nextRandom(&rng) % 100; }
+    run("uniform", f_s);
+
+    for (int s = 0; s < 256; s++) { f_s[s] = s < 40 ? (1ULL << (40 - s)) : 0; }
+    run("skewed", f_s);
+
+    memset(f_s, 0, sizeof f_s);
+    for (int s = 'a'; s < 'a' + 8; s++) { f_s[s] = 1 + nextRandom(&rng) % 50; }
+    run("small", f_s);
+
+    // Comprobación de equivalencia con histogramas aleatorios (incluye empates).
+    int mismatches = 0;
+    for (int trial = 0; trial < 2000; trial++) {
+        int used = 1 + (int)(nextRandom(&rng) % 256);
+        memset(f_s, 0, sizeof f_s);
+        for (int i = 0; i < used; i++) { f_s[nextRandom(&rng) % 256] = 1 + nextRandom(&rng) % 8; }
+        if (!sameLengths(f_s)) { mismatches++; }
+    }
+    printf("random histograms: %d mismatches out of 2000\n", mismatches);
+    return mismatches != 0;
+}
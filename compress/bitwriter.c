@@ -1,37 +1,128 @@
+#define _POSIX_C_SOURCE 200809L   // posix_memalign con -std=c11
 #include "bitwriter.h"
+#include "io.h"
+#include "stats.h"
+#include <stdlib.h>
 #include <unistd.h>
 
-void bitWriterInit(BitWriter *bw, int fd) {
+int bitWriterInit(BitWriter *bw, int fd) {
     bw->fd = fd;
-    bw->buffer = 0;
-    bw->bits_in_buffer = 0;
+    bw->acc = 0;
+    bw->bits_in_acc = 0;
+    bw->out_pos = 0;
+    bw->out_cap = BITWRITER_BUFFER_SIZE;
+    bw->flushed = 0;
+    bw->error = 0;
+    bw->owns_out = 1;
+    bw->writer = NULL;
+    bw->spare = NULL;
+    bw->out = malloc(bw->out_cap);
+    return bw->out ? 0 : -1;
 }
 
-void bitWriterWrite(BitWriter *bw, uint64_t bits, int count) {
-    for (int i = count - 1; i >= 0; i--) {
-        unsigned char bit = (bits >> i) & 1;
-        
-        bw->buffer = (bw->buffer << 1) | bit;
-        bw->bits_in_buffer++;
-        
-        if (bw->bits_in_buffer == 8) {
-            write(bw->fd, &bw->buffer, 1);
-            bw->buffer = 0;
-            bw->bits_in_buffer = 0;
+int bitWriterInitAsync(BitWriter *bw, struct AsyncWriter *writer) {
+    bw->fd = writer->fd;
+    bw->acc = 0;
+    bw->bits_in_acc = 0;
+    bw->out_pos = 0;
+    bw->out_cap = BITWRITER_BUFFER_SIZE;
+    bw->flushed = 0;
+    bw->error = 0;
+    bw->owns_out = 1;
+    bw->writer = writer;
+    bw->out = NULL;
+    bw->spare = NULL;
+    if (posix_memalign((void **)&bw->out, IO_BUFFER_ALIGN, bw->out_cap) != 0 ||
+        posix_memalign((void **)&bw->spare, IO_BUFFER_ALIGN, bw->out_cap) != 0) {
+        free(bw->out);
+        bw->out = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void bitWriterInitBuffer(BitWriter *bw, unsigned char *dst, size_t cap) {
+    bw->fd = -1;
+    bw->acc = 0;
+    bw->bits_in_acc = 0;
+    bw->out = dst;
+    bw->out_pos = 0;
+    bw->out_cap = cap;
+    bw->flushed = 0;
+    bw->error = 0;
+    bw->owns_out = 0;
+    bw->writer = NULL;
+    bw->spare = NULL;
+}
+
+void bitWriterDrain(BitWriter *bw) {
+    // En modo memoria no hay a dónde vaciar: el buffer del llamador se quedó corto.
+    if (bw->fd < 0) {
+        bw->error = 1;
+        bw->out_pos = 0;
+        return;
+    }
+
+    // Con writer: se entrega el buffer lleno y se sigue en el otro, que ya terminó de escribirse.
+    if (bw->writer) {
+        struct iovec iov = { bw->out, bw->out_pos };
+        if (asyncWriterSubmit(bw->writer, &iov, 1, 0) != 0) { bw->error = 1; }
+        unsigned char *filled = bw->out;
+        bw->out = bw->spare;
+        bw->spare = filled;
+        bw->flushed += bw->out_pos;
+        bw->out_pos = 0;
+        return;
+    }
+
+    STATS_TIMER(timer);
+    size_t done = 0;
+    while (done < bw->out_pos) {
+        ssize_t n = write(bw->fd, bw->out + done, bw->out_pos - done);
+        STATS_SYSCALL(STAT_SYS_WRITE);
+        if (n <= 0) {
+            bw->error = 1;
+            break;
         }
+        done += (size_t)n;
     }
+    STATS_STOP(timer, STAT_IO, 0, done);
+    bw->flushed += bw->out_pos;
+    bw->out_pos = 0;
 }
 
 int bitWriterFlush(BitWriter *bw) {
-    if (bw->bits_in_buffer == 0) {return 0;}
-    
-    int trailing_bits = 8 - bw->bits_in_buffer;
-    bw->buffer = bw->buffer << trailing_bits;
-    
-    write(bw->fd, &bw->buffer, 1);
-    
-    bw->buffer = 0;
-    bw->bits_in_buffer = 0;
-    
-    return trailing_bits;
+    // Bytes completos que quedan en el acumulador.
+    while (bw->bits_in_acc >= 8) {
+        if (bw->out_pos == bw->out_cap) { bitWriterDrain(bw); }
+        bw->bits_in_acc -= 8;
+        bw->out[bw->out_pos++] = (unsigned char)(bw->acc >> bw->bits_in_acc);
+    }
+
+    int trailing_bits = 0;
+    if (bw->bits_in_acc > 0) {
+        if (bw->out_pos == bw->out_cap) { bitWriterDrain(bw); }
+        trailing_bits = 8 - bw->bits_in_acc;
+        bw->out[bw->out_pos++] = (unsigned char)(bw->acc << trailing_bits);
+    }
+
+    if (bw->fd >= 0) { bitWriterDrain(bw); }
+    if (bw->writer && asyncWriterWait(bw->writer) != 0) { bw->error = 1; }
+
+    bw->acc = 0;
+    bw->bits_in_acc = 0;
+
+    return bw->error ? -1 : trailing_bits;
+}
+
+void bitWriterFree(BitWriter *bw) {
+    // El writer no debe seguir leyendo un buffer que se libera.
+    if (bw->writer) { asyncWriterWait(bw->writer); }
+    if (bw->owns_out) {
+        free(bw->out);
+        free(bw->spare);
+    }
+    bw->spare = NULL;
+    bw->out = NULL;
+    bw->out_cap = 0;
 }
@@ -3,15 +3,79 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
+
+#define BITWRITER_BUFFER_SIZE (1 << 20)   // bytes buffered before each write()
+
+struct AsyncWriter;
 
 typedef struct BitWriter {
-    int fd;                  // descriptor
-    unsigned char buffer;
-    int bits_in_buffer;      // numero actual de bits en el buffer (0-7)
+    int fd;                  // descriptor (-1: solo memoria)
+    uint64_t acc;            // acumulador: los bits pendientes están en la parte baja
+    int bits_in_acc;         // bits pendientes en acc (0-31 entre llamadas)
+    unsigned char *out;      // buffer de salida en espacio de usuario
+    size_t out_pos;          // bytes ocupados en out
+    size_t out_cap;
+    uint64_t flushed;        // bytes ya entregados (write() o writer) antes de out
+    int error;               // 1 si algún write() falló o el buffer no alcanzó
+    int owns_out;            // 1 si out fue reservado por bitWriterInit
+    struct AsyncWriter *writer;   // escritura en segundo plano (NULL: write() directo)
+    unsigned char *spare;    // segundo buffer: se llena mientras el writer escribe el otro
 } BitWriter;
 
-void bitWriterInit(BitWriter *bw, int fd);
-void bitWriterWrite(BitWriter *bw, uint64_t bits, int count);
+// Allocates the output buffer
+// Returns: 0 on success, -1 on error
+int bitWriterInit(BitWriter *bw, int fd);
+
+// Hands full buffers to a background writer instead of calling write()
+// Two page-aligned buffers of BITWRITER_BUFFER_SIZE alternate: one is filled while the
+// writer issues the other; output starts at the writer's current offset
+// Returns: 0 on success, -1 on error
+int bitWriterInitAsync(BitWriter *bw, struct AsyncWriter *writer);
+
+// Writes into a caller-owned buffer instead of a descriptor
+// dst: destination buffer, cap: its size in bytes
+// Running out of space sets bw->error; the bytes written are bw->out_pos after bitWriterFlush
+void bitWriterInitBuffer(BitWriter *bw, unsigned char *dst, size_t cap);
+
+// Writes the buffered bytes to the descriptor and empties the buffer
+void bitWriterDrain(BitWriter *bw);
+
+// Appends the low count bits of bits, most significant first
+// bits must not have anything set above bit count-1
+static inline void bitWriterWrite(BitWriter *bw, uint64_t bits, int count) {
+    if (count > 32) {
+        bitWriterWrite(bw, bits >> 32, count - 32);
+        bits &= 0xffffffffULL;
+        count = 32;
+    }
+
+    bw->acc = (bw->acc << count) | bits;
+    bw->bits_in_acc += count;
+
+    if (bw->bits_in_acc >= 32) {
+        if (bw->out_pos + 4 > bw->out_cap) { bitWriterDrain(bw); }
+        bw->bits_in_acc -= 32;
+        uint32_t word = (uint32_t)(bw->acc >> bw->bits_in_acc);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        word = __builtin_bswap32(word);
+#endif
+        memcpy(bw->out + bw->out_pos, &word, 4);
+        bw->out_pos += 4;
+    }
+}
+
+// Bits written so far, counted from the start of the output
+static inline uint64_t bitWriterTell(const BitWriter *bw) {
+    return (bw->flushed + bw->out_pos) * 8 + (uint64_t)bw->bits_in_acc;
+}
+
+// Pads the last byte with zeros and writes everything still buffered
+// (with a background writer, waits until it is on disk)
+// Returns: number of padding bits (0-7), or -1 if a write failed
 int bitWriterFlush(BitWriter *bw);
 
+// Releases the output buffer
+void bitWriterFree(BitWriter *bw);
+
 #endif // BITWRITER_H
@@ -1,68 +1,248 @@
 #include "compress.h"
 #include "bitwriter.h"
+#include "io.h"
+#include "histogram.h"
+#include "crc32c.h"
+#include "stats.h"
 #include <fcntl.h>
 #include <unistd.h>
+#include <stdlib.h>
 #include <string.h>
 
-int compressFile(const unsigned char *input, size_t input_size, const char *output_path, const Code codes[256]) {
-    int fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (fd < 0) {
-        return -1;
-    }
+// Índice de saltos en construcción: posición en bits de cada múltiplo de interval.
+typedef struct SeekIndex {
+    uint32_t interval;    // 0: sin índice
+    uint32_t count;
+    uint32_t cap;
+    uint64_t *bits;
+    uint64_t pos;         // símbolos codificados hasta ahora
+    int checksum;         // 1: crc acumula el CRC32C de la entrada
+    uint32_t crc;
+} SeekIndex;
 
-    if (write(fd, "HUF1", 4) != 4) {
-        close(fd);
-        return -1;
+// Cabecera HUF1; el byte de trailing bits se completa al terminar el payload.
+// Si ningún código tiene bits (un único símbolo, symbol) queda como HUF1_FLAG_RLE.
+// Returns: 1 si es RLE y no hay bitstream que escribir, 0 si no.
+static int buildHeader(unsigned char header[HUF1_HEADER_SIZE], uint64_t original_size, const Code codes[256],
+                       unsigned char symbol) {
+    int coded = 0;
+    memcpy(header, "HUF1", 4);
+    memcpy(header + 4, &original_size, sizeof(uint64_t));
+    for (int i = 0; i < 256; i++) {
+        header[12 + i] = (unsigned char)codes[i].length;
+        coded |= codes[i].length != 0;
     }
-
-    uint64_t original_size = (uint64_t)input_size;
-    if (write(fd, &original_size, sizeof(uint64_t)) != sizeof(uint64_t)) {
-        close(fd);
-        return -1;
+    header[268] = 0;
+    if (coded || original_size == 0) {
+        return 0;
     }
+    header[12 + symbol] = 1;
+    header[268] = HUF1_FLAG_RLE;
+    return 1;
+}
 
-    unsigned char lens[256];
-    for (int i = 0; i < 256; i++) {
-        lens[i] = (unsigned char)codes[i].length;
+// Crea output_path y un BitWriter cuyos buffers escribe otro hilo con pwritev()
+// a partir del final de la cabecera, que se escribe al cerrar.
+static int openOutput(const char *output_path, int *fd, AsyncWriter *aw, BitWriter *bw) {
+    *fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (*fd < 0) {
+        return -1;
     }
-    if (write(fd, lens, 256) != 256) {
-        close(fd);
+    if (asyncWriterStart(aw, *fd, HUF1_HEADER_SIZE) != 0) {
+        close(*fd);
         return -1;
     }
-
-    // ** para guardar la posición del byte de trailing bits.
-    off_t trailing_pos = lseek(fd, 0, SEEK_CUR);
-    unsigned char trailing_placeholder = 0;
-    if (write(fd, &trailing_placeholder, 1) != 1) {
-        close(fd);
+    if (bitWriterInitAsync(bw, aw) != 0) {
+        asyncWriterFinish(aw);
+        close(*fd);
         return -1;
     }
+    return 0;
+}
 
-    BitWriter bw;
-    bitWriterInit(&bw, fd);
+// Vacía el BitWriter, espera al writer, añade el CRC y el índice (si hay) tras el
+// bitstream y escribe la cabecera ya completa en el offset 0.
+static int closeOutput(int fd, AsyncWriter *aw, BitWriter *bw, unsigned char header[HUF1_HEADER_SIZE],
+                       const SeekIndex *index) {
+    int trailing_bits = bitWriterFlush(bw);
+    uint64_t payload = bw->flushed;
+    bitWriterFree(bw);
+    int rc = asyncWriterFinish(aw);
+    if (trailing_bits < 0) { rc = -1; }
+    header[268] |= (unsigned char)trailing_bits;
 
+    // Tras el bitstream: el CRC (si hay) y luego el índice (si hay), en un solo pwritev().
+    struct iovec iov[3];
+    int iovcnt = 0;
+    unsigned char tail[HUF1_SEEK_TRAILER_SIZE];
+    uint32_t crc = index->crc;
+    if (index->checksum) {
+        iov[iovcnt].iov_base = &crc;
+        iov[iovcnt++].iov_len = sizeof crc;
+        header[268] |= HUF1_FLAG_CRC;
+    }
+    if (index->interval > 0) {
+        memcpy(tail, &index->interval, 4);
+        memcpy(tail + 4, &index->count, 4);
+        memcpy(tail + 8, "HSK1", 4);
+        iov[iovcnt].iov_base = index->bits;
+        iov[iovcnt++].iov_len = (size_t)index->count * sizeof(uint64_t);
+        iov[iovcnt].iov_base = tail;
+        iov[iovcnt++].iov_len = sizeof tail;
+        header[268] |= HUF1_FLAG_SEEK_INDEX;
+    }
+    if (rc == 0 && iovcnt > 0) {
+        rc = pwritevAll(fd, iov, iovcnt, HUF1_HEADER_SIZE + payload);
+    }
+    if (rc == 0) {
+        struct iovec iov = {header, HUF1_HEADER_SIZE};
+        rc = pwritevAll(fd, &iov, 1, 0);
+    }
+    if (close(fd) != 0) { rc = -1; }
+    return rc;
+}
+
+static void encodeBuffer(BitWriter *bw, const unsigned char *input, size_t input_size, const Code codes[256]) {
+    STATS_TIMER(timer);
+    uint64_t start = bitWriterTell(bw);
     for (size_t i = 0; i < input_size; i++) {
         unsigned char byte = input[i];
         Code code = codes[byte];
-        
+
         if (code.length > 0) {
-            bitWriterWrite(&bw, code.bits, (int)code.length);
+            bitWriterWrite(bw, code.bits, (int)code.length);
+        }
+    }
+    STATS_STOP(timer, STAT_ENCODE, input_size, (bitWriterTell(bw) - start) / 8);
+}
+
+// Codifica input registrando un punto de control antes de cada símbolo múltiplo de interval.
+static int encodeIndexed(BitWriter *bw, const unsigned char *input, size_t input_size, const Code codes[256],
+                         SeekIndex *index) {
+    // Con checksum se avanza de a COMPRESS_CRC_SLICE bytes: el CRC los trae a la caché
+    // y la codificación los lee de ahí, sin otra pasada sobre la entrada.
+    if (index->checksum) {
+        index->checksum = 0;
+        int rc = 0;
+        for (size_t off = 0; rc == 0 && off < input_size; off += COMPRESS_CRC_SLICE) {
+            size_t n = input_size - off < COMPRESS_CRC_SLICE ? input_size - off : COMPRESS_CRC_SLICE;
+            index->crc = crc32cUpdate(index->crc, input + off, n);
+            rc = encodeIndexed(bw, input + off, n, codes, index);
+        }
+        index->checksum = 1;
+        return rc;
+    }
+
+    if (index->interval == 0) {
+        encodeBuffer(bw, input, input_size, codes);
+        index->pos += input_size;
+        return 0;
+    }
+
+    size_t i = 0;
+    while (i < input_size) {
+        uint64_t next = (uint64_t)(index->count + 1) * index->interval;
+        if (index->pos == next) {
+            if (index->count == index->cap) {
+                if (index->cap == UINT32_MAX) { return -1; }
+                uint32_t cap = index->cap ? (index->cap > UINT32_MAX / 2 ? UINT32_MAX : index->cap * 2) : 256;
+                uint64_t *bits = realloc(index->bits, (size_t)cap * sizeof(uint64_t));
+                if (!bits) { return -1; }
+                index->bits = bits;
+                index->cap = cap;
+            }
+            index->bits[index->count++] = bitWriterTell(bw);
+            continue;
         }
+        size_t run = input_size - i;
+        if (next - index->pos < run) { run = (size_t)(next - index->pos); }
+        encodeBuffer(bw, input + i, run, codes);
+        i += run;
+        index->pos += run;
     }
+    return 0;
+}
+
+int compressFile(const unsigned char *input, size_t input_size, const char *output_path, const Code codes[256]) {
+    return compressFileSeekable(input, input_size, output_path, codes, 0, 0);
+}
 
-    int trailing_bits = bitWriterFlush(&bw);
+int compressFileSeekable(const unsigned char *input, size_t input_size, const char *output_path,
+                         const Code codes[256], uint32_t seek_interval, int checksum) {
+    unsigned char header[HUF1_HEADER_SIZE];
+    if (buildHeader(header, (uint64_t)input_size, codes, input_size ? input[0] : 0)) {
+        seek_interval = 0;   // nada que indexar: cualquier rango es el mismo byte
+    }
 
-    if (lseek(fd, trailing_pos, SEEK_SET) < 0) {
-        close(fd);
+    int fd;
+    AsyncWriter aw;
+    BitWriter bw;
+    if (openOutput(output_path, &fd, &aw, &bw) != 0) {
         return -1;
     }
-    
-    unsigned char trailing_byte = (unsigned char)trailing_bits;
-    if (write(fd, &trailing_byte, 1) != 1) {
-        close(fd);
+
+    SeekIndex index = {seek_interval, 0, 0, NULL, 0, checksum != 0, 0};
+    int rc = encodeIndexed(&bw, input, input_size, codes, &index);
+    if (closeOutput(fd, &aw, &bw, header, &index) != 0) { rc = -1; }
+    free(index.bits);
+    return rc;
+}
+
+int compressStream(int in_fd, const char *output_path, size_t chunk_size, int max_code_len,
+                   uint32_t seek_interval, int checksum) {
+    if (chunk_size == 0) { chunk_size = COMPRESS_STREAM_CHUNK; }
+
+    unsigned char *chunk = malloc(chunk_size);
+    if (!chunk) {
         return -1;
     }
 
-    close(fd);
-    return 0;
+    // Primera pasada: histograma de 64 bits por bloques.
+    uint64_t f_s[256] = {0};
+    uint64_t total = 0;
+    off_t start = lseek(in_fd, 0, SEEK_CUR);
+    ssize_t n;
+    while ((n = readUpTo(in_fd, chunk, chunk_size)) > 0) {
+        histogramAdd(chunk, (size_t)n, f_s);
+        total += (uint64_t)n;
+    }
+    if (n < 0 || start < 0) {
+        free(chunk);
+        return -1;
+    }
+
+    Code codes[256];
+    if (huffmanBuildLimitedCodes(f_s, max_code_len, codes) < 0) {
+        free(chunk);
+        return -1;
+    }
+
+    unsigned char symbol = 0;
+    for (int s = 0; s < 256; s++) {
+        if (f_s[s] != 0) { symbol = (unsigned char)s; }
+    }
+    unsigned char header[HUF1_HEADER_SIZE];
+    if (buildHeader(header, total, codes, symbol)) {
+        seek_interval = 0;
+    }
+
+    int fd;
+    AsyncWriter aw;
+    BitWriter bw;
+    if (lseek(in_fd, start, SEEK_SET) < 0 || openOutput(output_path, &fd, &aw, &bw) != 0) {
+        free(chunk);
+        return -1;
+    }
+
+    // Segunda pasada: codificar; el archivo no debe cambiar entre pasadas.
+    SeekIndex index = {seek_interval, 0, 0, NULL, 0, checksum != 0, 0};
+    int failed = 0;
+    while (!failed && (n = readUpTo(in_fd, chunk, chunk_size)) > 0) {
+        failed = encodeIndexed(&bw, chunk, (size_t)n, codes, &index) != 0;
+    }
+    free(chunk);
+
+    int rc = closeOutput(fd, &aw, &bw, header, &index);
+    free(index.bits);
+    return (failed || n < 0 || index.pos != total) ? -1 : rc;
 }
@@ -5,6 +5,24 @@
 #include <stddef.h>
 #include "huffman.h"
 
+// HUF1 layout: "HUF1" | original_size u64 | lens[256] | flags byte | MSB-first bitstream
+// Bits 0-2 of the flags byte are the padding bits of the last bitstream byte.
+// With HUF1_FLAG_RLE set, the data is original_size copies of the only byte with a nonzero
+// length and there is no bitstream (plain Huffman gives a lone symbol a 0-bit code).
+// With HUF1_FLAG_CRC set, the CRC32C of the original data (u32) follows the bitstream.
+// With HUF1_FLAG_SEEK_INDEX set, a seek index comes last:
+//   bit_offsets u64[count] | interval u32 | count u32 | "HSK1"
+// bit_offsets[k-1] is the bitstream position of symbol k * interval (k = 1..count),
+// so decoding can start at any checkpoint instead of at the beginning.
+#define HUF1_HEADER_SIZE (4 + 8 + 256 + 1)
+#define HUF1_PADDING_MASK 0x07
+#define HUF1_FLAG_CRC 0x20
+#define HUF1_FLAG_RLE 0x40
+#define HUF1_FLAG_SEEK_INDEX 0x80
+#define HUF1_SEEK_TRAILER_SIZE 12
+#define COMPRESS_DEFAULT_SEEK_INTERVAL (64 << 10)
+#define COMPRESS_CRC_SLICE (64 << 10)   // bytes checksummed and then encoded while still in cache
+
 // Compress data using Huffman coding
 // input: input data buffer
 // input_size: size of input data
@@ -12,4 +30,27 @@
 // Returns: 0 on success, -1 on error
 int compressFile(const unsigned char *input, size_t input_size, const char *output_path, const Code codes[256]);
 
+// Same as compressFile, appending a seek index with a checkpoint every seek_interval bytes
+// seek_interval: uncompressed bytes between checkpoints (0 = no index)
+// checksum: 1 = store the CRC32C of the input, computed during the encoding pass
+// With neither, the output is the same as compressFile
+// Returns: 0 on success, -1 on error
+int compressFileSeekable(const unsigned char *input, size_t input_size, const char *output_path,
+                         const Code codes[256], uint32_t seek_interval, int checksum);
+
+#define COMPRESS_STREAM_CHUNK (16 << 20)
+
+// Compress a seekable input in two passes of chunk_size reads (histogram, then encode)
+// Memory stays bounded by chunk_size regardless of the input size; output is HUF1,
+// identical to compressFile with the same table
+// in_fd: input descriptor, read from its current offset to the end
+// output_path: path to write compressed file
+// chunk_size: bytes per read (0 = COMPRESS_STREAM_CHUNK)
+// max_code_len: longest code in bits (0 = unlimited)
+// seek_interval: bytes between seek index checkpoints (0 = no index)
+// checksum: 1 = store the CRC32C of the input
+// Returns: 0 on success, -1 on error
+int compressStream(int in_fd, const char *output_path, size_t chunk_size, int max_code_len,
+                   uint32_t seek_interval, int checksum);
+
 #endif // COMPRESS_H
@@ -0,0 +1,78 @@
+#include "crc32c.h"
+#include <pthread.h>
+#include <string.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define CRC32C_HAVE_SSE42 1
+#else
+#define CRC32C_HAVE_SSE42 0
+#endif
+
+#define CRC32C_POLY 0x82F63B78u   // polinomio de Castagnoli, reflejado
+
+typedef uint32_t (*CrcFn)(uint32_t crc, const unsigned char *buf, size_t n);
+
+static uint32_t crc_tables[8][256];
+static CrcFn crc_impl;
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static inline uint32_t load32le(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Slicing-by-8: 8 bytes por iteración con 8 consultas independientes.
+static uint32_t crcSliced(uint32_t crc, const unsigned char *buf, size_t n) {
+    while (n >= 8) {
+        uint32_t lo = crc ^ load32le(buf);
+        uint32_t hi = load32le(buf + 4);
+        crc = crc_tables[7][lo & 0xFF] ^ crc_tables[6][(lo >> 8) & 0xFF] ^
+              crc_tables[5][(lo >> 16) & 0xFF] ^ crc_tables[4][lo >> 24] ^
+              crc_tables[3][hi & 0xFF] ^ crc_tables[2][(hi >> 8) & 0xFF] ^
+              crc_tables[1][(hi >> 16) & 0xFF] ^ crc_tables[0][hi >> 24];
+        buf += 8;
+        n -= 8;
+    }
+    while (n--) { crc = crc_tables[0][(crc ^ *buf++) & 0xFF] ^ (crc >> 8); }
+    return crc;
+}
+
+#if CRC32C_HAVE_SSE42
+__attribute__((target("sse4.2")))
+static uint32_t crcHardware(uint32_t crc, const unsigned char *buf, size_t n) {
+    uint64_t c = crc;
+    while (n >= 8) {
+        uint64_t v;
+        memcpy(&v, buf, sizeof v);
+        c = _mm_crc32_u64(c, v);
+        buf += 8;
+        n -= 8;
+    }
+    uint32_t c32 = (uint32_t)c;
+    while (n--) { c32 = _mm_crc32_u8(c32, *buf++); }
+    return c32;
+}
+#endif
+
+static void crcInit(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) { c = (c >> 1) ^ (CRC32C_POLY & (0u - (c & 1))); }
+        crc_tables[0][i] = c;
+    }
+    for (int t = 1; t < 8; t++) {
+        for (int i = 0; i < 256; i++) {
+            uint32_t c = crc_tables[t - 1][i];
+            crc_tables[t][i] = crc_tables[0][c & 0xFF] ^ (c >> 8);
+        }
+    }
+
+    crc_impl = crcSliced;
+#if CRC32C_HAVE_SSE42
+    if (__builtin_cpu_supports("sse4.2")) { crc_impl = crcHardware; }
+#endif
+}
+
+uint32_t crc32cUpdate(uint32_t crc, const unsigned char *buf, size_t n) {
+    pthread_once(&crc_once, crcInit);
+    return ~crc_impl(~crc, buf, n);
+}
@@ -0,0 +1,16 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC32C (Castagnoli polynomial), the checksum of the SSE4.2 crc32 instruction.
+// Uses that instruction when the CPU has SSE4.2 (checked once at run time) and
+// slicing-by-8 tables otherwise; both give the same value.
+
+// Extends crc with n more bytes
+// crc: value returned for the preceding bytes (0 to start)
+// Returns: the CRC32C of everything so far
+uint32_t crc32cUpdate(uint32_t crc, const unsigned char *buf, size_t n);
+
+#endif // CRC32C_H
@@ -0,0 +1,450 @@
+#include "decompress.h"
+#include "compress.h"
+#include "parallel.h"
+#include "io.h"
+#include "crc32c.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HUF_FAST_STEPS (57 / HUF_TABLE_BITS)
+
+static int decodeLong(const DecodeTable *t, uint64_t window, unsigned char *sym, int *len) {
+    for (int l = HUF_TABLE_BITS + 1; l <= t->max_len; l++) {
+        uint64_t d = (window >> (64 - l)) - t->first_code[l];
+        if (d < t->len_count[l]) {
+            *sym = t->sorted[t->first_index[l] + d];
+            *len = l;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int buildDecodeTable(DecodeTable *table, const unsigned char lens[256]) {
+    STATS_TIMER(timer);
+    Code codes[256];
+    if (huffmanCodesFromLengths(lens, codes) < 0) { return -1; }
+
+    memset(table, 0, sizeof *table);
+    memcpy(table->lens, lens, 256);
+    for (int s = 0; s < 256; s++) {
+        if (lens[s] > table->max_len) { table->max_len = lens[s]; }
+    }
+    if (table->max_len > HUF_MAX_DECODE_LEN) { return -1; }
+
+    // Tabla canónica para los códigos largos (mismo orden que buildCanonicalCodes).
+    int k = 0;
+    for (int l = 1; l <= table->max_len; l++) {
+        table->first_index[l] = (uint16_t)k;
+        for (int s = 0; s < 256; s++) {
+            if (lens[s] != l) { continue; }
+            if (table->len_count[l] == 0) { table->first_code[l] = codes[s].bits; }
+            table->sorted[k++] = (unsigned char)s;
+            table->len_count[l]++;
+        }
+    }
+
+    // Primero una tabla de un símbolo por entrada...
+    struct { unsigned char sym; uint8_t len; } single[1 << HUF_TABLE_BITS];
+    memset(single, 0, sizeof single);
+    for (int s = 0; s < 256; s++) {
+        int len = lens[s];
+        if (len == 0 || len > HUF_TABLE_BITS) { continue; }
+        uint32_t start = (uint32_t)codes[s].bits << (HUF_TABLE_BITS - len);
+        uint32_t end = start + (1u << (HUF_TABLE_BITS - len));
+        for (uint32_t i = start; i < end; i++) {
+            single[i].sym = (unsigned char)s;
+            single[i].len = (uint8_t)len;
+        }
+    }
+
+    // ...y luego se encadenan todos los códigos completos que caben en HUF_TABLE_BITS bits.
+    const uint32_t mask = (1u << HUF_TABLE_BITS) - 1;
+    for (uint32_t i = 0; i <= mask; i++) {
+        DecodeEntry *e = &table->entries[i];
+        int used = 0;
+        while (e->count < HUF_TABLE_SYMBOLS) {
+            uint32_t sub = (i << used) & mask;
+            int len = single[sub].len;
+            if (len == 0 || len > HUF_TABLE_BITS - used) { break; }
+            e->symbols[e->count++] = single[sub].sym;
+            used += len;
+        }
+        e->bits = (uint8_t)used;
+    }
+    STATS_STOP(timer, STAT_DECODE_TABLE, 0, 0);
+    return 0;
+}
+
+// Un paso sin saltos: una entrada larga (count == 0) no consume bits, así que
+// los pasos siguientes la repiten sin efecto y se resuelve al recargar.
+#define DECODE_STEP()                                                          \
+    do {                                                                       \
+        e = &entries[(window << consumed) >> (64 - HUF_TABLE_BITS)];           \
+        memcpy(dst + out, e->symbols, HUF_TABLE_SYMBOLS);                      \
+        out += e->count;                                                       \
+        consumed += e->bits;                                                   \
+    } while (0)
+
+// Decodifica desde (bitpos, out) hasta completar dst_size símbolos.
+static int decodeRange(const DecodeTable *table, const unsigned char *src, size_t src_size,
+                       uint64_t bitpos, unsigned char *dst, size_t out, size_t dst_size) {
+    const DecodeEntry *entries = table->entries;
+    const uint64_t total_bits = (uint64_t)src_size * 8;
+
+    if (out >= dst_size) { return 0; }
+    if (table->max_len == 0) { return -1; }
+
+    // Camino rápido: una recarga de 64 bits deja al menos 57 bits válidos,
+    // suficientes para HUF_FAST_STEPS consultas de HUF_TABLE_BITS bits.
+    while ((size_t)(bitpos >> 3) + 8 <= src_size && out + HUF_FAST_STEPS * HUF_TABLE_SYMBOLS <= dst_size) {
+        uint64_t window = load64be(src + (bitpos >> 3)) << (bitpos & 7);
+        unsigned consumed = 0;
+        const DecodeEntry *e;
+
+        DECODE_STEP();
+        DECODE_STEP();
+        DECODE_STEP();
+        DECODE_STEP();
+#if HUF_FAST_STEPS > 4
+        DECODE_STEP();
+#endif
+
+        // Código largo al inicio de la ventana: aquí sí quedan >= 57 bits válidos.
+        if (consumed == 0) {
+            unsigned char sym;
+            int len;
+            if (decodeLong(table, window, &sym, &len) != 0) { return -1; }
+            dst[out++] = sym;
+            consumed = (unsigned)len;
+        }
+        bitpos += consumed;
+    }
+
+    // Cola: un símbolo por iteración, sin leer fuera del buffer.
+    while (out < dst_size) {
+        if (bitpos >= total_bits) { return -1; }
+        uint64_t window = loadWindow(src, src_size, bitpos);
+        const DecodeEntry *e = &entries[window >> (64 - HUF_TABLE_BITS)];
+        unsigned char sym;
+        int len;
+        if (e->count == 0) {
+            if (decodeLong(table, window, &sym, &len) != 0) { return -1; }
+        } else {
+            sym = e->symbols[0];
+            len = table->lens[sym];
+        }
+        dst[out++] = sym;
+        bitpos += (uint64_t)len;
+    }
+
+    return (bitpos <= total_bits) ? 0 : -1;
+}
+
+int huffmanDecode(const DecodeTable *table, const unsigned char *src, size_t src_size,
+                  unsigned char *dst, size_t dst_size) {
+    return decodeRange(table, src, src_size, 0, dst, 0, dst_size);
+}
+
+// Bucle intercalado; se instancia con nstreams constante para que el compilador
+// desenrolle los streams y mantenga ventanas y posiciones en registros.
+static inline int decodeInterleaved(const DecodeTable *table, int nstreams,
+                                    const unsigned char *const src[], const size_t src_size[],
+                                    unsigned char *const dst[], const size_t dst_size[],
+                                    uint64_t bitpos[], size_t out[]) {
+    const DecodeEntry *entries = table->entries;
+
+    // Todos los streams avanzan en la misma iteración: son cadenas de dependencia
+    // independientes que el procesador ejecuta solapadas.
+    for (;;) {
+        int k;
+        for (k = 0; k < nstreams; k++) {
+            if ((size_t)(bitpos[k] >> 3) + 8 > src_size[k] ||
+                out[k] + HUF_FAST_STEPS * HUF_TABLE_SYMBOLS > dst_size[k]) { break; }
+        }
+        if (k < nstreams) { break; }
+
+        uint64_t window[HUF_MAX_STREAMS];
+        unsigned consumed[HUF_MAX_STREAMS];
+        for (k = 0; k < nstreams; k++) {
+            window[k] = load64be(src[k] + (bitpos[k] >> 3)) << (bitpos[k] & 7);
+            consumed[k] = 0;
+        }
+        for (int step = 0; step < HUF_FAST_STEPS; step++) {
+            for (k = 0; k < nstreams; k++) {
+                const DecodeEntry *e = &entries[(window[k] << consumed[k]) >> (64 - HUF_TABLE_BITS)];
+                memcpy(dst[k] + out[k], e->symbols, HUF_TABLE_SYMBOLS);
+                out[k] += e->count;
+                consumed[k] += e->bits;
+            }
+        }
+        for (k = 0; k < nstreams; k++) {
+            if (consumed[k] == 0) {
+                unsigned char sym;
+                int len;
+                if (decodeLong(table, window[k], &sym, &len) != 0) { return 1; }
+                dst[k][out[k]++] = sym;
+                consumed[k] = (unsigned)len;
+            }
+            bitpos[k] += consumed[k];
+        }
+    }
+    return 0;
+}
+
+int huffmanDecodeStreams(const DecodeTable *table, int nstreams,
+                         const unsigned char *const src[], const size_t src_size[],
+                         unsigned char *const dst[], const size_t dst_size[]) {
+    uint64_t bitpos[HUF_MAX_STREAMS] = {0};
+    size_t out[HUF_MAX_STREAMS] = {0};
+
+    if (nstreams < 1 || nstreams > HUF_MAX_STREAMS) { return -1; }
+    if (table->max_len == 0) {
+        for (int k = 0; k < nstreams; k++) {
+            if (dst_size[k] > 0) { return -1; }
+        }
+        return 0;
+    }
+
+    int failed;
+    switch (nstreams) {
+    case 2: failed = decodeInterleaved(table, 2, src, src_size, dst, dst_size, bitpos, out); break;
+    case 4: failed = decodeInterleaved(table, 4, src, src_size, dst, dst_size, bitpos, out); break;
+    case 8: failed = decodeInterleaved(table, 8, src, src_size, dst, dst_size, bitpos, out); break;
+    default: failed = decodeInterleaved(table, nstreams, src, src_size, dst, dst_size, bitpos, out); break;
+    }
+    if (failed) { return -1; }
+
+    // Cada stream termina por separado.
+    for (int k = 0; k < nstreams; k++) {
+        if (decodeRange(table, src[k], src_size[k], bitpos[k], dst[k], out[k], dst_size[k]) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Vista de un HUF1: bitstream sin CRC ni índice de saltos y, si existen, sus valores.
+typedef struct Huf1View {
+    const unsigned char *stream;
+    size_t stream_size;
+    const unsigned char *checkpoints;   // u64 por punto de control, sin alinear
+    uint32_t interval;                  // 0: sin índice
+    uint32_t count;
+    int checksum;                       // 1: crc es el CRC32C de los datos originales
+    uint32_t crc;
+} Huf1View;
+
+// El índice va al final: se lee desde la cola hacia atrás.
+static int parseSeekIndex(const unsigned char *in, size_t in_size, Huf1View *view) {
+    if (view->stream_size < HUF1_SEEK_TRAILER_SIZE) { return -1; }
+    const unsigned char *tail = in + in_size - HUF1_SEEK_TRAILER_SIZE;
+    uint32_t interval, count;
+    memcpy(&interval, tail, 4);
+    memcpy(&count, tail + 4, 4);
+    size_t index_size = (size_t)count * sizeof(uint64_t) + HUF1_SEEK_TRAILER_SIZE;
+    if (memcmp(tail + 8, "HSK1", 4) != 0 || interval == 0 || index_size > view->stream_size) {
+        return -1;
+    }
+    view->stream_size -= index_size;
+    view->checkpoints = view->stream + view->stream_size;
+    view->interval = interval;
+    view->count = count;
+    return 0;
+}
+
+static int parseHuf1(const unsigned char *in, size_t in_size, Huf1View *view) {
+    if (in_size < HUF1_HEADER_SIZE ||
+        (in[268] & ~(HUF1_PADDING_MASK | HUF1_FLAG_CRC | HUF1_FLAG_RLE | HUF1_FLAG_SEEK_INDEX)) != 0) {
+        return -1;
+    }
+    view->stream = in + HUF1_HEADER_SIZE;
+    view->stream_size = in_size - HUF1_HEADER_SIZE;
+    view->checkpoints = NULL;
+    view->interval = 0;
+    view->count = 0;
+    view->checksum = 0;
+    view->crc = 0;
+    if ((in[268] & HUF1_FLAG_SEEK_INDEX) && parseSeekIndex(in, in_size, view) != 0) {
+        return -1;
+    }
+
+    // El CRC queda justo antes del índice.
+    if (in[268] & HUF1_FLAG_CRC) {
+        if (view->stream_size < sizeof view->crc) { return -1; }
+        view->stream_size -= sizeof view->crc;
+        memcpy(&view->crc, view->stream + view->stream_size, sizeof view->crc);
+        view->checksum = 1;
+    }
+    return 0;
+}
+
+// HUF1_FLAG_RLE: el único símbolo con longitud es todo el contenido.
+// Returns: ese símbolo, o -1 si no hay exactamente uno.
+static int rleSymbol(const unsigned char *in) {
+    int symbol = -1;
+    for (int s = 0; s < 256; s++) {
+        if (in[12 + s] == 0) { continue; }
+        if (symbol >= 0) { return -1; }
+        symbol = s;
+    }
+    return symbol;
+}
+
+// Cuerpo HUF1: tabla de longitudes, byte de flags y el bitstream.
+int huffmanDecodeHuf1(DecodeTable *table, const unsigned char *in, size_t in_size,
+                      unsigned char *out, size_t out_size) {
+    STATS_TIMER(timer);
+    Huf1View view;
+    if (parseHuf1(in, in_size, &view) != 0) {
+        return -1;
+    }
+    if (in[268] & HUF1_FLAG_RLE) {
+        int symbol = rleSymbol(in);
+        if (symbol < 0) { return -1; }
+        memset(out, symbol, out_size);
+    } else if (buildDecodeTable(table, in + 12) != 0 ||
+               huffmanDecode(table, view.stream, view.stream_size, out, out_size) != 0) {
+        return -1;
+    }
+    STATS_STOP(timer, STAT_DECODE, in_size, out_size);
+    return (view.checksum && crc32cUpdate(0, out, out_size) != view.crc) ? -1 : 0;
+}
+
+static int decodeHuf1(const unsigned char *in, size_t in_size, unsigned char *out, size_t out_size) {
+    DecodeTable *table = malloc(sizeof *table);
+    if (!table) {
+        return -1;
+    }
+    int rc = huffmanDecodeHuf1(table, in, in_size, out, out_size);
+    free(table);
+    return rc;
+}
+
+// Rango de un HUF1: desde el último punto de control anterior a offset (o desde el
+// principio si no hay índice) hasta offset + length.
+static int decodeHuf1Range(const unsigned char *in, size_t in_size, uint64_t offset, size_t length,
+                           unsigned char *dst) {
+    Huf1View view;
+    if (parseHuf1(in, in_size, &view) != 0) {
+        return -1;
+    }
+    if (in[268] & HUF1_FLAG_RLE) {
+        int symbol = rleSymbol(in);
+        if (symbol < 0) { return -1; }
+        memset(dst, symbol, length);
+        return 0;
+    }
+
+    uint64_t start = 0, bitpos = 0;
+    // count == 0 pasa parseSeekIndex: sin puntos de control se empieza desde el principio.
+    if (view.interval > 0 && view.count > 0 && offset >= view.interval) {
+        uint64_t k = offset / view.interval;
+        if (k > view.count) { k = view.count; }
+        memcpy(&bitpos, view.checkpoints + (k - 1) * sizeof(uint64_t), sizeof(uint64_t));
+        start = k * view.interval;
+        if (bitpos > (uint64_t)view.stream_size * 8) { return -1; }
+    }
+
+    size_t span = (size_t)(offset + length - start);
+    unsigned char *tmp = malloc(span);
+    DecodeTable *table = malloc(sizeof *table);
+    int rc = -1;
+    STATS_TIMER(timer);
+    if (tmp && table && buildDecodeTable(table, in + 12) == 0) {
+        rc = decodeRange(table, view.stream, view.stream_size, bitpos, tmp, 0, span);
+    }
+    STATS_STOP(timer, STAT_DECODE, view.stream_size - bitpos / 8, span);
+    if (rc == 0) { memcpy(dst, tmp + (offset - start), length); }
+    free(table);
+    free(tmp);
+    return rc;
+}
+
+int decompressRange(const unsigned char *in, size_t in_size, uint64_t offset, size_t length,
+                    unsigned char *dst) {
+    if (in_size < 12) {
+        return -1;
+    }
+    uint64_t original_size;
+    memcpy(&original_size, in + 4, sizeof(uint64_t));
+    if (offset > original_size || length > original_size - offset) {
+        return -1;
+    }
+
+    if (memcmp(in, "HUF1", 4) == 0) {
+        return length ? decodeHuf1Range(in, in_size, offset, length, dst) : 0;
+    }
+    if (memcmp(in, "HUF2", 4) == 0) {
+        return decompressBlocksRange(in, in_size, offset, length, dst, defaultThreadCount());
+    }
+    return -1;
+}
+
+int decompressBuffer(const unsigned char *in, size_t in_size, unsigned char **out, size_t *out_size) {
+    // HUF1 y HUF2 empiezan igual: magic + tamaño original.
+    if (in_size < 12) {
+        return -1;
+    }
+    uint64_t original_size;
+    memcpy(&original_size, in + 4, sizeof(uint64_t));
+    if (original_size > SIZE_MAX) {
+        return -1;
+    }
+
+    unsigned char *buf = malloc(original_size ? (size_t)original_size : 1);
+    if (!buf) {
+        return -1;
+    }
+
+    int rc = -1;
+    if (memcmp(in, "HUF1", 4) == 0) {
+        rc = decodeHuf1(in, in_size, buf, (size_t)original_size);
+    } else if (memcmp(in, "HUF2", 4) == 0) {
+        rc = decompressBlocks(in, in_size, buf, (size_t)original_size, defaultThreadCount());
+    }
+    if (rc != 0) {
+        free(buf);
+        return -1;
+    }
+
+    *out = buf;
+    *out_size = (size_t)original_size;
+    return 0;
+}
+
+int decompressFile(const char *input_path, const char *output_path) {
+    MappedFile in;
+    if (mapFile(input_path, &in) != 0) {
+        return -1;
+    }
+
+    unsigned char *out;
+    size_t out_size;
+    int rc = decompressBuffer(in.data, in.size, &out, &out_size);
+    unmapFile(&in);
+    if (rc != 0) {
+        return -1;
+    }
+
+    rc = writeFile(output_path, out, out_size);
+    free(out);
+    return rc;
+}
+
+int decompressFileRange(const char *input_path, const char *output_path, uint64_t offset, size_t length) {
+    MappedFile in;
+    if (mapFile(input_path, &in) != 0) {
+        return -1;
+    }
+
+    unsigned char *out = malloc(length ? length : 1);
+    int rc = out ? decompressRange(in.data, in.size, offset, length, out) : -1;
+    unmapFile(&in);
+    if (rc == 0) {
+        rc = writeFile(output_path, out, length);
+    }
+    free(out);
+    return rc;
+}
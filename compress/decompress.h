@@ -0,0 +1,108 @@
+#ifndef DECOMPRESS_H
+#define DECOMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "huffman.h"
+
+#define HUF_TABLE_BITS 11        // bits resolved per table lookup
+#define HUF_TABLE_SYMBOLS 4      // max symbols decoded per table lookup
+#define HUF_MAX_DECODE_LEN 56    // longest code the 64-bit bit window can hold
+#define HUF_MAX_STREAMS 8        // interleaved streams per block
+
+// One lookup table slot: every symbol whose code fits completely
+// in the next HUF_TABLE_BITS bits of the stream
+typedef struct DecodeEntry {
+    unsigned char symbols[HUF_TABLE_SYMBOLS];
+    uint8_t count;     // symbols resolved (0: code longer than HUF_TABLE_BITS)
+    uint8_t bits;      // bits consumed by those symbols
+    uint8_t pad[2];    // 8-byte entries: indexed without multiplies
+} DecodeEntry;
+
+typedef struct DecodeTable {
+    DecodeEntry entries[1 << HUF_TABLE_BITS];
+    int max_len;
+    // canonical decoding for codes longer than HUF_TABLE_BITS
+    uint64_t first_code[HUF_MAX_DECODE_LEN + 1];
+    uint16_t first_index[HUF_MAX_DECODE_LEN + 1];
+    uint16_t len_count[HUF_MAX_DECODE_LEN + 1];
+    unsigned char sorted[256];
+    unsigned char lens[256];
+} DecodeTable;
+
+// Big-endian 64-bit load from a possibly unaligned pointer
+static inline uint64_t load64be(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof v);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+// Returns: the 64 bits of an MSB-first stream starting at bitpos, left-aligned;
+// bytes past src_size read as zero
+static inline uint64_t loadWindow(const unsigned char *src, size_t src_size, uint64_t bitpos) {
+    size_t pos = (size_t)(bitpos >> 3);
+    uint64_t v = 0;
+    if (pos + 8 <= src_size) {
+        v = load64be(src + pos);
+    } else {
+        for (size_t i = 0; i < 8; i++) {
+            v <<= 8;
+            if (pos + i < src_size) { v |= src[pos + i]; }
+        }
+    }
+    return v << (bitpos & 7);
+}
+
+// Builds the multi-symbol decode table from canonical code lengths
+// lens: code length per symbol as stored in the HUF1 header
+// Returns: 0 on success, -1 if the lengths are invalid
+int buildDecodeTable(DecodeTable *table, const unsigned char lens[256]);
+
+// Decodes exactly dst_size symbols from an MSB-first bitstream
+// src: bitstream, src_size: bitstream size in bytes
+// Returns: 0 on success, -1 on corrupt or truncated input
+int huffmanDecode(const DecodeTable *table, const unsigned char *src, size_t src_size,
+                  unsigned char *dst, size_t dst_size);
+
+// Decodes nstreams independent bitstreams that share one table, advancing all of them
+// in the same loop so their dependency chains overlap
+// src[k], src_size[k]: bitstream k; dst[k], dst_size[k]: its output segment
+// Returns: 0 on success, -1 on corrupt or truncated input
+int huffmanDecodeStreams(const DecodeTable *table, int nstreams,
+                         const unsigned char *const src[], const size_t src_size[],
+                         unsigned char *const dst[], const size_t dst_size[]);
+
+// Decodes a HUF1 container (with or without seek index) using caller-provided table storage
+// out: buffer of out_size bytes, the original size stored in the header
+// Returns: 0 on success, -1 on corrupt input
+int huffmanDecodeHuf1(DecodeTable *table, const unsigned char *in, size_t in_size,
+                      unsigned char *out, size_t out_size);
+
+// Decodes a HUF1 or HUF2 container held in memory into a malloc'd buffer
+// out: receives the original data (the caller frees it), out_size: its size
+// Returns: 0 on success, -1 on error
+int decompressBuffer(const unsigned char *in, size_t in_size, unsigned char **out, size_t *out_size);
+
+// Decompress a HUF1 or HUF2 file written by compressFile or compressFileParallel
+// input_path: compressed file
+// output_path: path to write the original data
+// Returns: 0 on success, -1 on error
+int decompressFile(const char *input_path, const char *output_path);
+
+// Decodes bytes [offset, offset + length) of a HUF1 or HUF2 container held in memory
+// HUF1 starts at the nearest seek index checkpoint (from the beginning without an index);
+// HUF2 decodes only the blocks that overlap the range
+// dst: buffer of length bytes
+// Returns: 0 on success, -1 on corrupt input or a range outside the original data
+int decompressRange(const unsigned char *in, size_t in_size, uint64_t offset, size_t length,
+                    unsigned char *dst);
+
+// Writes bytes [offset, offset + length) of the original data of input_path to output_path
+// Returns: 0 on success, -1 on error
+int decompressFileRange(const char *input_path, const char *output_path, uint64_t offset, size_t length);
+
+#endif // DECOMPRESS_H
@@ -0,0 +1,302 @@
+#include "fse.h"
+#include <string.h>
+
+typedef struct FseSymbolTransform {
+    int32_t delta_find_state;
+    uint32_t delta_nb_bits;
+} FseSymbolTransform;
+
+typedef struct FseDecodeEntry {
+    uint16_t new_state;
+    unsigned char symbol;
+    uint8_t nb_bits;
+} FseDecodeEntry;
+
+static inline int highBit(uint32_t v) {
+    return 31 - __builtin_clz(v);
+}
+
+static inline uint64_t load64le(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof v);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline void store64le(unsigned char *p, uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    memcpy(p, &v, sizeof v);
+}
+
+int fseTableLog(size_t n, int used) {
+    int log = FSE_DEFAULT_TABLE_LOG;
+    // Bloques pequeños: una tabla más grande que la entrada solo agranda el estado.
+    int max_src = n > 4 ? highBit((uint32_t)(n - 1 > UINT32_MAX ? UINT32_MAX : n - 1)) - 1 : FSE_MIN_TABLE_LOG;
+    int min_sym = used > 1 ? highBit((uint32_t)(used - 1)) + 2 : FSE_MIN_TABLE_LOG;
+    if (log > max_src) { log = max_src; }
+    if (log < min_sym) { log = min_sym; }
+    if (log < FSE_MIN_TABLE_LOG) { log = FSE_MIN_TABLE_LOG; }
+    if (log > FSE_MAX_TABLE_LOG) { log = FSE_MAX_TABLE_LOG; }
+    return log;
+}
+
+int fseNormalizeCounts(const uint64_t f_s[256], int table_log, uint16_t norm[256]) {
+    const uint32_t table_size = 1u << table_log;
+    uint64_t total = 0;
+    int used = 0, largest = -1;
+    for (int s = 0; s < 256; s++) {
+        total += f_s[s];
+        if (f_s[s] == 0) { continue; }
+        used++;
+        if (largest < 0 || f_s[s] > f_s[largest]) { largest = s; }
+    }
+    if (used == 0 || (uint32_t)used > table_size) { return -1; }
+
+    // Redondeo proporcional; la diferencia se ajusta en el símbolo más frecuente.
+    int64_t sum = 0;
+    for (int s = 0; s < 256; s++) {
+        norm[s] = 0;
+        if (f_s[s] == 0) { continue; }
+        uint64_t n = (uint64_t)((double)f_s[s] * table_size / (double)total + 0.5);
+        if (n == 0) { n = 1; }
+        if (n > table_size) { n = table_size; }
+        norm[s] = (uint16_t)n;
+        sum += (int64_t)n;
+    }
+    int64_t diff = (int64_t)table_size - sum;
+    if ((int64_t)norm[largest] + diff >= 1) {
+        norm[largest] = (uint16_t)(norm[largest] + diff);
+        return used;
+    }
+
+    // Muchos símbolos raros forzados a 1: se quita de a uno a los más grandes.
+    while (sum > (int64_t)table_size) {
+        int big = largest;
+        for (int s = 0; s < 256; s++) {
+            if (norm[s] > norm[big]) { big = s; }
+        }
+        norm[big]--;
+        sum--;
+    }
+    return used;
+}
+
+// log2(x) en punto fijo Q16 para x >= 1 (cuadrados sucesivos, exacto hasta 2^-16).
+static uint32_t log2Fixed(uint32_t x) {
+    int hb = highBit(x);
+    uint32_t result = (uint32_t)hb << 16;
+    uint64_t m = ((uint64_t)x << 16) >> hb;   // mantisa en [1, 2) en Q16
+    for (uint32_t bit = 1u << 15; bit != 0; bit >>= 1) {
+        m = (m * m) >> 16;
+        if (m >= (2u << 16)) {
+            m >>= 1;
+            result |= bit;
+        }
+    }
+    return result;
+}
+
+uint64_t fseEncodedBits(const uint64_t f_s[256], const uint16_t norm[256], int table_log) {
+    uint64_t cost = 0;   // en 1/65536 bits
+    for (int s = 0; s < 256; s++) {
+        if (f_s[s] == 0 || norm[s] == 0) { continue; }
+        uint32_t per_symbol = ((uint32_t)table_log << 16) - log2Fixed(norm[s]);
+        cost += f_s[s] * per_symbol;
+    }
+    return (cost + 0xFFFF) >> 16;
+}
+
+// Reparte los símbolos en la tabla con un paso coprimo con su tamaño.
+static int spreadSymbols(const uint16_t norm[256], int table_log, unsigned char *table_symbol) {
+    const uint32_t table_size = 1u << table_log;
+    const uint32_t mask = table_size - 1;
+    const uint32_t step = (table_size >> 1) + (table_size >> 3) + 3;
+    uint32_t pos = 0, total = 0;
+    for (int s = 0; s < 256; s++) {
+        total += norm[s];
+        for (uint32_t i = 0; i < norm[s]; i++) {
+            table_symbol[pos] = (unsigned char)s;
+            pos = (pos + step) & mask;
+        }
+    }
+    return (total == table_size && pos == 0) ? 0 : -1;
+}
+
+size_t fseEncode(const uint16_t norm[256], int table_log, const unsigned char *src, size_t n,
+                 unsigned char *dst, size_t dst_cap) {
+    if (table_log < FSE_MIN_TABLE_LOG || table_log > FSE_MAX_TABLE_LOG || n == 0) { return 0; }
+    const uint32_t table_size = 1u << table_log;
+
+    unsigned char table_symbol[1 << FSE_MAX_TABLE_LOG];
+    if (spreadSymbols(norm, table_log, table_symbol) != 0) { return 0; }
+
+    // Estados siguientes de cada símbolo, en el orden en que aparecen en la tabla.
+    uint16_t state_table[1 << FSE_MAX_TABLE_LOG];
+    uint32_t cumul[257];
+    cumul[0] = 0;
+    for (int s = 0; s < 256; s++) { cumul[s + 1] = cumul[s] + norm[s]; }
+    for (uint32_t u = 0; u < table_size; u++) {
+        state_table[cumul[table_symbol[u]]++] = (uint16_t)(table_size + u);
+    }
+
+    FseSymbolTransform tt[256];
+    uint32_t total = 0;
+    for (int s = 0; s < 256; s++) {
+        uint32_t count = norm[s];
+        if (count == 0) {
+            tt[s].delta_find_state = 0;
+            tt[s].delta_nb_bits = 0;
+            continue;
+        }
+        uint32_t max_bits_out = (uint32_t)table_log - (count > 1 ? (uint32_t)highBit(count - 1) : 0);
+        if (count == 1) { max_bits_out = (uint32_t)table_log; }
+        uint32_t min_state_plus = count << max_bits_out;
+        tt[s].delta_nb_bits = (max_bits_out << 16) - min_state_plus;
+        tt[s].delta_find_state = (int32_t)total - (int32_t)count;
+        total += count;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (norm[src[i]] == 0) { return 0; }
+    }
+
+    // Dos estados alternados (símbolos pares e impares): el decodificador avanza
+    // dos cadenas de dependencia independientes. Los dos últimos símbolos fijan
+    // los estados iniciales sin emitir bits.
+    uint32_t state[2] = {table_size, table_size};
+    size_t i = n;
+    for (int k = 0; k < 2 && i > 0; k++) {
+        i--;
+        const FseSymbolTransform *t = &tt[src[i]];
+        uint32_t nb = (t->delta_nb_bits + (1u << 15)) >> 16;
+        uint32_t value = (nb << 16) - t->delta_nb_bits;
+        state[i & 1] = state_table[(int32_t)(value >> nb) + t->delta_find_state];
+    }
+
+    uint64_t acc = 0;
+    unsigned bits = 0;
+    size_t pos = 0;
+    while (i-- > 0) {
+        if (pos + FSE_STREAM_SLACK > dst_cap) { return 0; }
+        const FseSymbolTransform *t = &tt[src[i]];
+        uint32_t st = state[i & 1];
+        uint32_t nb = (st + t->delta_nb_bits) >> 16;
+        acc |= (uint64_t)(st & ((1u << nb) - 1)) << bits;
+        bits += nb;
+        state[i & 1] = state_table[(int32_t)(st >> nb) + t->delta_find_state];
+
+        // Volcado sin saltos: se escriben 8 bytes y se avanza lo completo.
+        store64le(dst + pos, acc);
+        pos += bits >> 3;
+        acc >>= bits & ~7u;
+        bits &= 7;
+    }
+
+    // Estados finales (el de los pares queda arriba) y centinela.
+    for (int k = 1; k >= 0; k--) {
+        if (pos + FSE_STREAM_SLACK > dst_cap) { return 0; }
+        acc |= (uint64_t)(state[k] - table_size) << bits;
+        bits += (unsigned)table_log;
+        store64le(dst + pos, acc);
+        pos += bits >> 3;
+        acc >>= bits & ~7u;
+        bits &= 7;
+    }
+    acc |= (uint64_t)1 << bits;
+    bits += 1;
+    store64le(dst + pos, acc);
+    return pos + (bits + 7) / 8;
+}
+
+// Bits [bitpos, bitpos + nb) del stream; los bytes fuera del buffer valen cero.
+static inline uint32_t readBits(const unsigned char *src, size_t src_size, uint64_t bitpos, uint32_t nb) {
+    size_t pos = (size_t)(bitpos >> 3);
+    uint64_t v = 0;
+    if (pos + 8 <= src_size) {
+        v = load64le(src + pos);
+    } else {
+        for (size_t k = 0; pos + k < src_size && k < 8; k++) { v |= (uint64_t)src[pos + k] << (8 * k); }
+    }
+    return (uint32_t)(v >> (bitpos & 7)) & ((1u << nb) - 1);
+}
+
+int fseDecode(const uint16_t norm[256], int table_log, const unsigned char *src, size_t src_size,
+              unsigned char *dst, size_t n) {
+    if (table_log < FSE_MIN_TABLE_LOG || table_log > FSE_MAX_TABLE_LOG) { return -1; }
+    if (n == 0) { return src_size == 0 ? 0 : -1; }
+    if (src_size == 0 || src[src_size - 1] == 0) { return -1; }
+    const uint32_t table_size = 1u << table_log;
+
+    unsigned char table_symbol[1 << FSE_MAX_TABLE_LOG];
+    if (spreadSymbols(norm, table_log, table_symbol) != 0) { return -1; }
+
+    FseDecodeEntry table[1 << FSE_MAX_TABLE_LOG];
+    uint32_t next[256];
+    for (int s = 0; s < 256; s++) { next[s] = norm[s]; }
+    for (uint32_t u = 0; u < table_size; u++) {
+        unsigned char s = table_symbol[u];
+        uint32_t next_state = next[s]++;
+        uint32_t nb = (uint32_t)table_log - (uint32_t)highBit(next_state);
+        table[u].symbol = s;
+        table[u].nb_bits = (uint8_t)nb;
+        table[u].new_state = (uint16_t)((next_state << nb) - table_size);
+    }
+
+    // El centinela es el bit más alto del último byte.
+    uint64_t bitpos = (uint64_t)src_size * 8 - 8 + (uint64_t)highBit(src[src_size - 1]);
+    if (bitpos < 2 * (uint64_t)table_log) { return -1; }
+    bitpos -= (uint64_t)table_log;
+    uint32_t even = readBits(src, src_size, bitpos, (uint32_t)table_log);
+    bitpos -= (uint64_t)table_log;
+    uint32_t odd = readBits(src, src_size, bitpos, (uint32_t)table_log);
+
+    // Los dos últimos símbolos salen de los estados iniciales, sin transición.
+    const size_t limit = n >= 2 ? n - 2 : 0;
+    size_t out = 0;
+
+    // Camino rápido: 4 símbolos por carga (4 * 12 bits caben en 57 bits válidos).
+    while (out + 4 <= limit && bitpos >= 64) {
+        uint64_t base = bitpos - 57;
+        uint64_t window = load64le(src + (base >> 3)) >> (base & 7);
+        unsigned avail = 57;
+        const FseDecodeEntry *e;
+
+        e = &table[even];
+        dst[out] = e->symbol;
+        avail -= e->nb_bits;
+        even = e->new_state + (uint32_t)((window >> avail) & ((1u << e->nb_bits) - 1));
+        e = &table[odd];
+        dst[out + 1] = e->symbol;
+        avail -= e->nb_bits;
+        odd = e->new_state + (uint32_t)((window >> avail) & ((1u << e->nb_bits) - 1));
+        e = &table[even];
+        dst[out + 2] = e->symbol;
+        avail -= e->nb_bits;
+        even = e->new_state + (uint32_t)((window >> avail) & ((1u << e->nb_bits) - 1));
+        e = &table[odd];
+        dst[out + 3] = e->symbol;
+        avail -= e->nb_bits;
+        odd = e->new_state + (uint32_t)((window >> avail) & ((1u << e->nb_bits) - 1));
+
+        out += 4;
+        bitpos = base + avail;
+    }
+    while (out < limit) {
+        uint32_t *state = (out & 1) ? &odd : &even;
+        const FseDecodeEntry *e = &table[*state];
+        if (bitpos < e->nb_bits) { return -1; }
+        dst[out++] = e->symbol;
+        bitpos -= e->nb_bits;
+        *state = e->new_state + readBits(src, src_size, bitpos, e->nb_bits);
+    }
+    for (; out < n; out++) {
+        dst[out] = table[(out & 1) ? odd : even].symbol;
+    }
+
+    // Todos los bits deben haberse consumido.
+    return bitpos == 0 ? 0 : -1;
+}
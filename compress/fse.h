@@ -0,0 +1,41 @@
+#ifndef FSE_H
+#define FSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Table-based asymmetric numeral systems (tANS / FSE) coder.
+// Symbols are encoded from the last to the first into a little-endian bitstream
+// that the decoder reads backwards, so decoding produces them in order.
+// Even and odd positions use separate states so the decoder runs two independent chains.
+// Stream: transition bits | odd state | even state (table_log bits each) | sentinel 1 bit | zero padding
+
+#define FSE_MIN_TABLE_LOG 5
+#define FSE_MAX_TABLE_LOG 12
+#define FSE_DEFAULT_TABLE_LOG 11
+#define FSE_STREAM_SLACK 8       // extra bytes fseEncode may touch past the encoded stream
+
+// Picks a table size for n symbols with used distinct values
+// Returns: table_log in FSE_MIN_TABLE_LOG..FSE_MAX_TABLE_LOG
+int fseTableLog(size_t n, int used);
+
+// Scales f_s so that the counts add up to 1 << table_log; every present symbol keeps at least 1
+// Returns: number of distinct symbols, or -1 if f_s is empty or has more symbols than table slots
+int fseNormalizeCounts(const uint64_t f_s[256], int table_log, uint16_t norm[256]);
+
+// Estimated size of the encoded stream, computed from the normalized counts
+// Returns: estimated bits (without the final states and sentinel)
+uint64_t fseEncodedBits(const uint64_t f_s[256], const uint16_t norm[256], int table_log);
+
+// Encodes src (n >= 1 symbols, all with norm > 0) into dst
+// dst_cap: must leave FSE_STREAM_SLACK spare bytes after the stream
+// Returns: stream size in bytes, or 0 if dst is too small
+size_t fseEncode(const uint16_t norm[256], int table_log, const unsigned char *src, size_t n,
+                 unsigned char *dst, size_t dst_cap);
+
+// Decodes exactly n symbols from a stream written by fseEncode
+// Returns: 0 on success, -1 on corrupt input or an invalid table
+int fseDecode(const uint16_t norm[256], int table_log, const unsigned char *src, size_t src_size,
+              unsigned char *dst, size_t n);
+
+#endif // FSE_H
@@ -0,0 +1,107 @@
+#include "histogram.h"
+#include "parallel.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define HISTOGRAM_TABLES 8
+#define HISTOGRAM_SEGMENT ((size_t)1 << 30)   // los contadores de 32 bits no desbordan
+
+static void countSegment(const unsigned char *buf, size_t n, uint64_t f_s[256]) {
+    uint32_t c[HISTOGRAM_TABLES][256];
+    memset(c, 0, sizeof c);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+#if defined(__SSE2__)
+        // 16 bytes iguales (ceros, relleno, texto repetido): un solo incremento.
+        __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+        __m128i first = _mm_set1_epi8((char)buf[i]);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, first)) == 0xFFFF) {
+            c[0][buf[i]] += 16;
+            continue;
+        }
+#endif
+        uint64_t x, y;
+        memcpy(&x, buf + i, 8);
+        memcpy(&y, buf + i + 8, 8);
+        c[0][(uint8_t)x]++;
+        c[1][(uint8_t)(x >> 8)]++;
+        c[2][(uint8_t)(x >> 16)]++;
+        c[3][(uint8_t)(x >> 24)]++;
+        c[4][(uint8_t)(x >> 32)]++;
+        c[5][(uint8_t)(x >> 40)]++;
+        c[6][(uint8_t)(x >> 48)]++;
+        c[7][(uint8_t)(x >> 56)]++;
+        c[0][(uint8_t)y]++;
+        c[1][(uint8_t)(y >> 8)]++;
+        c[2][(uint8_t)(y >> 16)]++;
+        c[3][(uint8_t)(y >> 24)]++;
+        c[4][(uint8_t)(y >> 32)]++;
+        c[5][(uint8_t)(y >> 40)]++;
+        c[6][(uint8_t)(y >> 48)]++;
+        c[7][(uint8_t)(y >> 56)]++;
+    }
+    for (; i < n; i++) { c[0][buf[i]]++; }
+
+    for (int s = 0; s < 256; s++) {
+        uint64_t total = 0;
+        for (int t = 0; t < HISTOGRAM_TABLES; t++) { total += c[t][s]; }
+        f_s[s] += total;
+    }
+}
+
+void histogramAdd(const unsigned char *buf, size_t n, uint64_t f_s[256]) {
+    STATS_TIMER(timer);
+    for (size_t off = 0; off < n; off += HISTOGRAM_SEGMENT) {
+        size_t len = n - off < HISTOGRAM_SEGMENT ? n - off : HISTOGRAM_SEGMENT;
+        countSegment(buf + off, len, f_s);
+    }
+    STATS_STOP(timer, STAT_HISTOGRAM, n, 0);
+}
+
+void histogramCount(const unsigned char *buf, size_t n, uint64_t f_s[256]) {
+    memset(f_s, 0, 256 * sizeof(uint64_t));
+    histogramAdd(buf, n, f_s);
+}
+
+typedef struct HistogramJob {
+    const unsigned char *buf;
+    size_t n;
+    size_t slice;
+    uint64_t (*partial)[256];
+} HistogramJob;
+
+static int countSlice(void *arg, uint32_t t) {
+    HistogramJob *job = arg;
+    size_t start = (size_t)t * job->slice;
+    size_t len = job->n - start < job->slice ? job->n - start : job->slice;
+    histogramCount(job->buf + start, len, job->partial[t]);
+    return 0;
+}
+
+void histogramCountParallel(const unsigned char *buf, size_t n, uint64_t f_s[256], int threads) {
+    if (threads <= 0) { threads = defaultThreadCount(); }
+    if ((size_t)threads > n / HISTOGRAM_PARALLEL_MIN) { threads = (int)(n / HISTOGRAM_PARALLEL_MIN); }
+
+    HistogramJob job;
+    job.partial = threads > 1 ? malloc((size_t)threads * sizeof *job.partial) : NULL;
+    if (!job.partial) {
+        histogramCount(buf, n, f_s);
+        return;
+    }
+
+    job.buf = buf;
+    job.n = n;
+    job.slice = (n + (size_t)threads - 1) / (size_t)threads;
+    parallelFor(countSlice, &job, (uint32_t)threads, threads);
+
+    memset(f_s, 0, 256 * sizeof(uint64_t));
+    for (int t = 0; t < threads; t++) {
+        for (int s = 0; s < 256; s++) { f_s[s] += job.partial[t][s]; }
+    }
+    free(job.partial);
+}
@@ -0,0 +1,22 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HISTOGRAM_PARALLEL_MIN (8 << 20)   // bytes per thread below which threads don't pay off
+
+// Adds the byte frequencies of buf to f_s
+// Uses 8 interleaved 32-bit sub-histograms so repeated bytes don't serialize on one counter,
+// and counts 16-byte runs of a single byte with one SSE2 compare
+void histogramAdd(const unsigned char *buf, size_t n, uint64_t f_s[256]);
+
+// Same as histogramAdd, but f_s is cleared first
+void histogramCount(const unsigned char *buf, size_t n, uint64_t f_s[256]);
+
+// Counts buf with up to threads threads (0 = defaultThreadCount()), one slice each,
+// and reduces the partial histograms into f_s (cleared first)
+// Small buffers are counted on the calling thread
+void histogramCountParallel(const unsigned char *buf, size_t n, uint64_t f_s[256], int threads);
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,196 @@
+#include "huf.h"
+#include "bitwriter.h"
+#include "histogram.h"
+#include "io.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const HufDict *findDict(const HufCtx *ctx, uint32_t id) {
+    for (int i = 0; i < ctx->dict_count; i++) {
+        if (ctx->dicts[i]->id == id) { return ctx->dicts[i]; }
+    }
+    return NULL;
+}
+
+void hufInitCtx(HufCtx *ctx, int max_code_len) {
+    memset(ctx, 0, sizeof *ctx);
+    ctx->max_code_len = max_code_len;
+}
+
+size_t hufCompressBound(size_t src_len) {
+    return HUF_COMPRESS_BOUND(src_len);
+}
+
+size_t hufCompress(HufCtx *ctx, const unsigned char *src, size_t src_len, unsigned char *dst, size_t dst_cap) {
+    if (dst_cap < HUF1_HEADER_SIZE) {
+        return 0;
+    }
+
+    histogramCount(src, src_len, ctx->f_s);
+    if (huffmanBuildLimitedCodes(ctx->f_s, ctx->max_code_len, ctx->codes) < 0) {
+        return 0;
+    }
+
+    uint64_t original_size = (uint64_t)src_len;
+    int coded = 0;
+    memcpy(dst, "HUF1", 4);
+    memcpy(dst + 4, &original_size, sizeof(uint64_t));
+    for (int i = 0; i < 256; i++) {
+        dst[12 + i] = (unsigned char)ctx->codes[i].length;
+        coded |= ctx->codes[i].length != 0;
+    }
+
+    // Un único símbolo no tiene bits que escribir: se marca como RLE.
+    if (!coded && src_len > 0) {
+        dst[12 + src[0]] = 1;
+        dst[268] = HUF1_FLAG_RLE;
+        return HUF1_HEADER_SIZE;
+    }
+
+    // El BitWriter escribe directo en dst; si no alcanza marca error en vez de vaciar.
+    BitWriter bw;
+    bitWriterInitBuffer(&bw, dst + HUF1_HEADER_SIZE, dst_cap - HUF1_HEADER_SIZE);
+    for (size_t i = 0; i < src_len; i++) {
+        Code code = ctx->codes[src[i]];
+        bitWriterWrite(&bw, code.bits, (int)code.length);
+    }
+    int trailing_bits = bitWriterFlush(&bw);
+    if (trailing_bits < 0) {
+        return 0;
+    }
+    dst[268] = (unsigned char)trailing_bits;
+    return HUF1_HEADER_SIZE + bw.out_pos;
+}
+
+// Mensaje HUFT: la tabla de decodificación ya está en el diccionario registrado.
+static int decompressDict(const HufCtx *ctx, const unsigned char *src, size_t src_len, unsigned char *dst,
+                          size_t dst_cap, size_t *dst_len) {
+    uint32_t dict_id, original_size;
+    memcpy(&dict_id, src + 4, sizeof(uint32_t));
+    memcpy(&original_size, src + 8, sizeof(uint32_t));
+    const HufDict *dict = findDict(ctx, dict_id);
+    if (!dict || original_size > dst_cap || src[12] > HUF1_PADDING_MASK) {
+        return -1;
+    }
+
+    if (huffmanDecode(&dict->table, src + HUFT_HEADER_SIZE, src_len - HUFT_HEADER_SIZE, dst, original_size) != 0) {
+        return -1;
+    }
+    *dst_len = original_size;
+    return 0;
+}
+
+int hufDecompress(HufCtx *ctx, const unsigned char *src, size_t src_len, unsigned char *dst, size_t dst_cap,
+                  size_t *dst_len) {
+    if (src_len >= HUFT_HEADER_SIZE && memcmp(src, "HUFT", 4) == 0) {
+        return decompressDict(ctx, src, src_len, dst, dst_cap, dst_len);
+    }
+    if (src_len < HUF1_HEADER_SIZE || memcmp(src, "HUF1", 4) != 0) {
+        return -1;
+    }
+    uint64_t original_size;
+    memcpy(&original_size, src + 4, sizeof(uint64_t));
+    if (original_size > dst_cap) {
+        return -1;
+    }
+
+    if (huffmanDecodeHuf1(&ctx->table, src, src_len, dst, (size_t)original_size) != 0) {
+        return -1;
+    }
+    *dst_len = (size_t)original_size;
+    return 0;
+}
+
+int hufTrainDict(HufDict *dict, uint32_t id, const uint64_t f_s[256], int max_code_len) {
+    if (max_code_len == 0) { max_code_len = HUF_DICT_DEFAULT_MAX_LEN; }
+    if (max_code_len < 8 || max_code_len > HUF_MAX_LIMIT) {
+        return -1;
+    }
+
+    // +1: un byte ausente de las muestras puede aparecer en un mensaje y necesita código.
+    uint64_t counts[256];
+    for (int i = 0; i < 256; i++) {
+        counts[i] = f_s[i] == UINT64_MAX ? f_s[i] : f_s[i] + 1;
+    }
+    unsigned char lens[256];
+    if (huffmanLimitedCodeLengths(counts, max_code_len, lens) < 0) {
+        return -1;
+    }
+    return hufDictFromLengths(dict, id, lens);
+}
+
+int hufDictFromLengths(HufDict *dict, uint32_t id, const unsigned char lens[256]) {
+    for (int i = 0; i < 256; i++) {
+        if (lens[i] == 0) { return -1; }
+    }
+    if (huffmanCodesFromLengths(lens, dict->codes) < 0 || buildDecodeTable(&dict->table, lens) != 0) {
+        return -1;
+    }
+    dict->id = id;
+    dict->max_len = dict->table.max_len;
+    memcpy(dict->lens, lens, 256);
+    return 0;
+}
+
+int hufSaveDict(const HufDict *dict, const char *path) {
+    unsigned char buf[HUF_DICT_FILE_SIZE];
+    memcpy(buf, "HUFD", 4);
+    memcpy(buf + 4, &dict->id, sizeof(uint32_t));
+    memcpy(buf + 8, dict->lens, 256);
+    return writeFile(path, buf, sizeof buf);
+}
+
+int hufLoadDict(HufDict *dict, const char *path) {
+    unsigned char *buf;
+    size_t size;
+    if (readFile(path, &buf, &size) != 0) {
+        return -1;
+    }
+    int rc = -1;
+    if (size == HUF_DICT_FILE_SIZE && memcmp(buf, "HUFD", 4) == 0) {
+        uint32_t id;
+        memcpy(&id, buf + 4, sizeof(uint32_t));
+        rc = hufDictFromLengths(dict, id, buf + 8);
+    }
+    free(buf);
+    return rc;
+}
+
+int hufAddDict(HufCtx *ctx, const HufDict *dict) {
+    if (ctx->dict_count == HUF_MAX_DICTS || findDict(ctx, dict->id)) {
+        return -1;
+    }
+    ctx->dicts[ctx->dict_count++] = dict;
+    return 0;
+}
+
+size_t hufCompressDictBound(const HufDict *dict, size_t src_len) {
+    return HUFT_HEADER_SIZE + (size_t)(((uint64_t)src_len * (uint64_t)dict->max_len + 7) / 8);
+}
+
+size_t hufCompressDict(HufCtx *ctx, uint32_t dict_id, const unsigned char *src, size_t src_len,
+                       unsigned char *dst, size_t dst_cap) {
+    const HufDict *dict = findDict(ctx, dict_id);
+    if (!dict || src_len > UINT32_MAX || dst_cap < HUFT_HEADER_SIZE) {
+        return 0;
+    }
+
+    uint32_t original_size = (uint32_t)src_len;
+    memcpy(dst, "HUFT", 4);
+    memcpy(dst + 4, &dict_id, sizeof(uint32_t));
+    memcpy(dst + 8, &original_size, sizeof(uint32_t));
+
+    // Una sola pasada: los códigos ya están construidos y todo byte tiene uno.
+    BitWriter bw;
+    bitWriterInitBuffer(&bw, dst + HUFT_HEADER_SIZE, dst_cap - HUFT_HEADER_SIZE);
+    for (size_t i = 0; i < src_len; i++) {
+        Code code = dict->codes[src[i]];
+        bitWriterWrite(&bw, code.bits, (int)code.length);
+    }
+    int trailing_bits = bitWriterFlush(&bw);
+    if (trailing_bits < 0) {
+        return 0;
+    }
+    dst[12] = (unsigned char)trailing_bits;
+    return HUFT_HEADER_SIZE + bw.out_pos;
+}
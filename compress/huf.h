@@ -0,0 +1,94 @@
+#ifndef HUF_H
+#define HUF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "huffman.h"
+#include "compress.h"
+#include "decompress.h"
+
+// In-memory HUF1 compression for many small payloads
+// The context holds the histogram, code and decode tables, so after hufInitCtx no call
+// allocates: every table lives in the context and every byte goes to caller buffers.
+// Output is a regular HUF1 container (readable by decompressBuffer / decompressFile).
+//
+// Dictionary mode: a code table trained offline is saved to a table file, loaded once and
+// registered in the context under its ID. Messages then skip the histogram, the code
+// build and the 256-byte length table: they are encoded in a single pass as
+//   "HUFT" | dict_id u32 | original_size u32 | trailing bits u8 | MSB-first bitstream
+// Table file: "HUFD" | dict_id u32 | lens[256] (every byte has a code)
+
+#define HUFT_HEADER_SIZE (4 + 4 + 4 + 1)
+#define HUF_DICT_FILE_SIZE (4 + 4 + 256)
+#define HUF_MAX_DICTS 16
+#define HUF_DICT_DEFAULT_MAX_LEN HUF_TABLE_BITS   // every code resolves in one table lookup
+
+// Shared code table; read-only once built, so one dictionary can serve many contexts and threads
+typedef struct HufDict {
+    uint32_t id;
+    int max_len;             // longest code in bits
+    unsigned char lens[256];
+    Code codes[256];
+    DecodeTable table;
+} HufDict;
+
+typedef struct HufCtx {
+    int max_code_len;        // longest code in bits (0 = unlimited)
+    uint64_t f_s[256];
+    Code codes[256];
+    DecodeTable table;
+    const HufDict *dicts[HUF_MAX_DICTS];   // registered dictionaries, looked up by id
+    int dict_count;
+} HufCtx;
+
+// Worst-case compressed size: rare bytes can get codes longer than 8 bits, but an optimal
+// prefix code never totals more than the 8 * n bits of the fixed 8-bit code
+#define HUF_COMPRESS_BOUND(n) ((size_t)HUF1_HEADER_SIZE + (size_t)(n))
+
+// Prepares a context; it can be reused for any number of calls (one thread at a time)
+// max_code_len: longest code in bits, 1..HUF_MAX_LIMIT (0 = unlimited)
+void hufInitCtx(HufCtx *ctx, int max_code_len);
+
+// Returns: dst_cap large enough for any src of src_len bytes
+size_t hufCompressBound(size_t src_len);
+
+// Compresses src into dst as a HUF1 container
+// dst_cap: hufCompressBound(src_len) always suffices
+// Returns: bytes written to dst, or 0 if dst is too small or the codes cannot be built
+size_t hufCompress(HufCtx *ctx, const unsigned char *src, size_t src_len, unsigned char *dst, size_t dst_cap);
+
+// Decompresses a HUF1 container, or a HUFT message whose dictionary is registered in ctx
+// dst_len: receives the original size
+// Returns: 0 on success, -1 on corrupt input, an unknown dictionary or dst_cap too small
+int hufDecompress(HufCtx *ctx, const unsigned char *src, size_t src_len, unsigned char *dst, size_t dst_cap,
+                  size_t *dst_len);
+
+// Builds a dictionary from the byte frequencies of a sample corpus
+// Every count is raised by one so bytes missing from the samples still get a code
+// max_code_len: longest code in bits, 8..HUF_MAX_LIMIT (0 = HUF_DICT_DEFAULT_MAX_LEN)
+// Returns: 0 on success, -1 on error
+int hufTrainDict(HufDict *dict, uint32_t id, const uint64_t f_s[256], int max_code_len);
+
+// Builds a dictionary from stored code lengths (all 256 must be nonzero)
+// Returns: 0 on success, -1 if the lengths are not a complete, decodable prefix code
+int hufDictFromLengths(HufDict *dict, uint32_t id, const unsigned char lens[256]);
+
+// Writes or reads a table file
+// Returns: 0 on success, -1 on error
+int hufSaveDict(const HufDict *dict, const char *path);
+int hufLoadDict(HufDict *dict, const char *path);
+
+// Registers dict under dict->id; the dictionary must outlive the context
+// Returns: 0 on success, -1 if the id is already registered or the context is full
+int hufAddDict(HufCtx *ctx, const HufDict *dict);
+
+// Returns: dst_cap large enough for any src of src_len bytes coded with dict
+size_t hufCompressDictBound(const HufDict *dict, size_t src_len);
+
+// Compresses src into dst as a HUFT message, in one pass over src
+// src_len: at most UINT32_MAX
+// Returns: bytes written to dst, or 0 if the dictionary is not registered or dst is too small
+size_t hufCompressDict(HufCtx *ctx, uint32_t dict_id, const unsigned char *src, size_t src_len,
+                       unsigned char *dst, size_t dst_cap);
+
+#endif // HUF_H
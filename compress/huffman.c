@@ -3,8 +3,9 @@
 #include <stdint.h>
 
 #include "huffman.h"
+#include "stats.h"
 
-static Code *g_codes_for_sort = NULL;
+static _Thread_local Code *g_codes_for_sort = NULL;
 huffmanNode* createNode(int symbol, uint64_t weight, unsigned long order) {
     huffmanNode* NewNode = malloc(sizeof *NewNode);
     if (NewNode == NULL) { return NULL; }
@@ -18,14 +19,14 @@ huffmanNode* createNode(int symbol, uint64_t weight, unsigned long order) {
     return NewNode;
 }
 
-// const int para no modificar f_s
+// const uint64_t para no modificar f_s
 // Importante cuando se llame debe ser malloc(256 * sizeof(huffmanNode*))
-size_t initializeTree(const int f_s[], huffmanNode* activeNodes[]) {
+size_t initializeTree(const uint64_t f_s[], huffmanNode* activeNodes[]) {
     size_t count = 0;
     unsigned long next_order = 0;
     for (int i = 0; i < 256; i++){
         if (f_s[i] > 0){
-            huffmanNode *n = createNode(i, (uint64_t)f_s[i], next_order++);
+            huffmanNode *n = createNode(i, f_s[i], next_order++);
             if (!n) {
                 for (size_t k = 0; k < count; ++k) free(activeNodes[k]);
                 return 0;
@@ -78,16 +79,17 @@ void buildCanonicalCodes(Code codes[256], const int symbols[], int m) {
         bl_count: bl_count[1]=1, bl_count[2]=2, bl_count[3]=1*/
 
     if (max_len == 0) { return; }
-    int *bl_count = calloc(max_len + 1, sizeof(int)); 
+    // En la pila: max_len < 256 y esto se llama por cada bloque.
+    int bl_count[256] = {0};
     for (int i = 0; i < m; ++i) {
         bl_count[codes[symbols[i]].length] += 1;
     }
 
     // first code para no utilizar un arbol.
-    uint32_t *first_code = calloc(max_len + 1, sizeof(uint32_t));
-    uint32_t code = 0;
+    uint64_t first_code[256];
+    uint64_t code = 0;
     for (int bits = 1; bits <= max_len; ++bits) {
-        code = (code + (uint32_t)bl_count[bits - 1]) << 1;
+        code = (code + (uint64_t)bl_count[bits - 1]) << 1;
         first_code[bits] = code;
     }
 
@@ -95,13 +97,39 @@ void buildCanonicalCodes(Code codes[256], const int symbols[], int m) {
     for (int i = 0; i < m; ++i) {
         int s = symbols[i];
         int len = (int)codes[s].length;
-        uint32_t assigned = first_code[len];
-        first_code[len] += 1;
-        codes[s].bits = (uint64_t)assigned;
+        codes[s].bits = first_code[len]++;
+    }
+}
+
+int huffmanCodesFromLengths(const unsigned char lens[256], Code codes[256]) {
+    int bl_count[65] = {0};
+    int m = 0;
+    for (int s = 0; s < 256; ++s) {
+        codes[s].bits = 0;
+        codes[s].length = lens[s];
+        if (lens[s] > 64) { return -1; }
+        if (lens[s] > 0) { bl_count[lens[s]]++; m++; }
     }
 
-    free(bl_count);
-    free(first_code);
+    // Kraft: no puede haber más códigos de longitud len que huecos libres.
+    int left = 1;
+    for (int len = 1; len <= 64; ++len) {
+        left = (left > 256) ? 512 : left << 1;
+        left -= bl_count[len];
+        if (left < 0) { return -1; }
+    }
+
+    // Orden canónico (longitud, símbolo) con counting sort, igual que codeSymbolComparator.
+    int next[65];
+    next[1] = 0;
+    for (int len = 1; len < 64; ++len) { next[len + 1] = next[len] + bl_count[len]; }
+    int symbols[256];
+    for (int s = 0; s < 256; ++s) {
+        if (lens[s] > 0) { symbols[next[lens[s]]++] = s; }
+    }
+
+    buildCanonicalCodes(codes, symbols, m);
+    return m;
 }
 
 void assignCodes(const huffmanNode* node, uint64_t cur_bits, int cur_len, Code codes[256]){
@@ -118,7 +146,7 @@ void assignCodes(const huffmanNode* node, uint64_t cur_bits, int cur_len, Code c
     assignCodes(node->right, (cur_bits << 1) | 1ULL, cur_len+1, codes);
 }
 
-huffmanNode* huffmanAlgorithm(const int f_s[], huffmanNode* activeNodes[], Code codes[256]) {
+huffmanNode* huffmanAlgorithm(const uint64_t f_s[], huffmanNode* activeNodes[], Code codes[256]) {
     size_t count = initializeTree(f_s, activeNodes);
 
     if (count == 0) return NULL;
@@ -161,6 +189,155 @@ huffmanNode* huffmanAlgorithm(const int f_s[], huffmanNode* activeNodes[], Code
 }
 
 
+// Ordena symbols[0..n) por (peso, símbolo) con un merge sort estable sin heap.
+static void sortByWeight(int symbols[], int n, const uint64_t f_s[]) {
+    int tmp[256];
+    for (int width = 1; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width < n ? lo + width : n;
+            int hi = lo + 2 * width < n ? lo + 2 * width : n;
+            int i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) {
+                tmp[k++] = (f_s[symbols[j]] < f_s[symbols[i]]) ? symbols[j++] : symbols[i++];
+            }
+            while (i < mid) { tmp[k++] = symbols[i++]; }
+            while (j < hi) { tmp[k++] = symbols[j++]; }
+        }
+        memcpy(symbols, tmp, (size_t)n * sizeof(int));
+    }
+}
+
+int huffmanCodeLengths(const uint64_t f_s[256], unsigned char lens[256]) {
+    int symbols[256];
+    int n = 0;
+    for (int s = 0; s < 256; ++s) {
+        if (f_s[s] > 0) { symbols[n++] = s; }
+    }
+    memset(lens, 0, 256);
+    if (n <= 1) { return n; }
+
+    // Hojas 0..n-1 ordenadas por (peso, símbolo); nodos internos n..2n-2 en orden de creación.
+    // Los internos salen con peso no decreciente, así que basta comparar los frentes de las
+    // dos colas; en empate gana la hoja, igual que el desempate por order de nodeComparator.
+    sortByWeight(symbols, n, f_s);
+    uint64_t weight[511];
+    int parent[511];
+    for (int i = 0; i < n; ++i) { weight[i] = f_s[symbols[i]]; }
+
+    int leaf = 0, node = n;
+    for (int next = n; next < 2 * n - 1; ++next) {
+        int pick[2];
+        for (int k = 0; k < 2; ++k) {
+            if (leaf < n && (node == next || weight[leaf] <= weight[node])) {
+                pick[k] = leaf++;
+            } else {
+                pick[k] = node++;
+            }
+        }
+        weight[next] = weight[pick[0]] + weight[pick[1]];
+        parent[pick[0]] = next;
+        parent[pick[1]] = next;
+    }
+
+    // Los padres siempre tienen índice mayor: profundidades de la raíz hacia abajo.
+    unsigned char depth[511];
+    depth[2 * n - 2] = 0;
+    for (int i = 2 * n - 3; i >= 0; --i) { depth[i] = (unsigned char)(depth[parent[i]] + 1); }
+    for (int i = 0; i < n; ++i) { lens[symbols[i]] = depth[i]; }
+    return n;
+}
+
+int huffmanBuildCodes(const uint64_t f_s[256], Code codes[256]) {
+    STATS_TIMER(timer);
+    unsigned char lens[256];
+    int n = huffmanCodeLengths(f_s, lens);
+    if (huffmanCodesFromLengths(lens, codes) < 0) { return -1; }
+    STATS_STOP(timer, STAT_CODE_BUILD, 0, 0);
+    return n;
+}
+
+int huffmanLimitedCodeLengths(const uint64_t f_s[256], int max_len, unsigned char lens[256]) {
+    int n = huffmanCodeLengths(f_s, lens);
+    if (max_len <= 0) { return n; }
+    if (max_len > HUF_MAX_LIMIT || (max_len < 8 && n > (1 << max_len))) { return -1; }
+
+    int longest = 0;
+    for (int s = 0; s < 256; ++s) {
+        if (lens[s] > longest) { longest = lens[s]; }
+    }
+    if (longest <= max_len) { return n; }   // Huffman ya cumple el límite: es óptimo
+
+    // Package-merge. Nivel 0 = hojas ordenadas; cada nivel siguiente mezcla las hojas con
+    // los paquetes (pares consecutivos) del nivel anterior. Solo hacen falta los primeros
+    // 2n-2 elementos de cada lista. item[l][i] >= 0 es una hoja, -1 un paquete.
+    int symbols[256];
+    int k = 0;
+    for (int s = 0; s < 256; ++s) {
+        if (f_s[s] > 0) { symbols[k++] = s; }
+    }
+    sortByWeight(symbols, n, f_s);
+
+    const int cap = 2 * n - 2;
+    short item[HUF_MAX_LIMIT][510];
+    int len_of[HUF_MAX_LIMIT];
+    uint64_t prev_w[510], cur_w[510];
+
+    for (int i = 0; i < n && i < cap; ++i) {
+        item[0][i] = (short)i;
+        prev_w[i] = f_s[symbols[i]];
+    }
+    len_of[0] = n < cap ? n : cap;
+
+    for (int l = 1; l < max_len; ++l) {
+        int packages = len_of[l - 1] / 2;
+        int li = 0, pi = 0, out = 0;
+        while (out < cap && (li < n || pi < packages)) {
+            uint64_t pw = pi < packages ? prev_w[2 * pi] + prev_w[2 * pi + 1] : 0;
+            if (li < n && (pi >= packages || f_s[symbols[li]] <= pw)) {
+                item[l][out] = (short)li;
+                cur_w[out++] = f_s[symbols[li++]];
+            } else {
+                item[l][out] = -1;
+                cur_w[out++] = pw;
+                pi++;
+            }
+        }
+        len_of[l] = out;
+        memcpy(prev_w, cur_w, (size_t)out * sizeof(uint64_t));
+    }
+
+    // Cada aparición de una hoja entre los elementos elegidos suma 1 a su longitud.
+    memset(lens, 0, 256);
+    int take = cap;
+    for (int l = max_len - 1; l >= 0 && take > 0; --l) {
+        int packages = 0;
+        for (int i = 0; i < take; ++i) {
+            if (item[l][i] >= 0) {
+                lens[symbols[item[l][i]]]++;
+            } else {
+                packages++;
+            }
+        }
+        take = 2 * packages;
+    }
+    return n;
+}
+
+int huffmanBuildLimitedCodes(const uint64_t f_s[256], int max_len, Code codes[256]) {
+    STATS_TIMER(timer);
+    unsigned char lens[256];
+    int n = huffmanLimitedCodeLengths(f_s, max_len, lens);
+    if (n < 0 || huffmanCodesFromLengths(lens, codes) < 0) { return -1; }
+    STATS_STOP(timer, STAT_CODE_BUILD, 0, 0);
+    return n;
+}
+
+uint64_t huffmanEncodedBits(const uint64_t f_s[256], const Code codes[256]) {
+    uint64_t bits = 0;
+    for (int s = 0; s < 256; ++s) { bits += f_s[s] * codes[s].length; }
+    return bits;
+}
+
 void freeHuffmanTree(huffmanNode* root) {
     if (root == NULL) {
         return;
@@ -4,6 +4,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#define HUF_MAX_LIMIT 32   // largest max_len accepted by the length-limited builders
+
 typedef struct huffmanNode {
     int symbol;              // Character/byte value (-1 for internal nodes)
     uint64_t weight;         // Frequency/weight
@@ -24,7 +26,7 @@ huffmanNode* createNode(int symbol, uint64_t weight, unsigned long order);
 // f_s: frequency array of size 256
 // activeNodes: array to store created nodes (must be pre-allocated: malloc(256 * sizeof(huffmanNode*)))
 // Returns: number of nodes created
-size_t initializeTree(const int f_s[], huffmanNode* activeNodes[]);
+size_t initializeTree(const uint64_t f_s[], huffmanNode* activeNodes[]);
 
 // Comparator function for qsort
 int nodeComparator(const void *a, const void *b);
@@ -34,11 +36,42 @@ int nodeComparator(const void *a, const void *b);
 void assignCodes(const huffmanNode* node, uint64_t cur_bits, int cur_len, Code codes[256]);
 
 
+// Rebuilds canonical codes from a code length table (e.g. a HUF1 header),
+// assigning bits exactly like buildCanonicalCodes does after huffmanAlgorithm
+// lens: code length per symbol (0 = unused)
+// Returns: number of symbols with a code, or -1 if the lengths are not a valid prefix code
+int huffmanCodesFromLengths(const unsigned char lens[256], Code codes[256]);
+
 // Builds the Huffman tree from frequency array
 // f_s: frequency array of size 256
 // activeNodes: working array (must be pre-allocated: malloc(256 * sizeof(huffmanNode*)))
 // Returns: root node of the Huffman tree, or NULL on error
-huffmanNode* huffmanAlgorithm(const int f_s[], huffmanNode* activeNodes[], Code codes[256]);
+huffmanNode* huffmanAlgorithm(const uint64_t f_s[], huffmanNode* activeNodes[], Code codes[256]);
+
+// Computes the same code lengths as huffmanAlgorithm without building a tree:
+// leaves sorted once, internal nodes taken from a second queue (two-queue method)
+// Runs in O(n log n) on stack arrays, with no heap allocation
+// A single used symbol gets length 0, like the lone leaf returned by huffmanAlgorithm
+// lens: receives the code length per symbol (0 = unused)
+// Returns: number of symbols with nonzero frequency
+int huffmanCodeLengths(const uint64_t f_s[256], unsigned char lens[256]);
+
+// huffmanCodeLengths followed by huffmanCodesFromLengths
+// Returns: number of symbols with nonzero frequency, or -1 if a code exceeds 64 bits
+int huffmanBuildCodes(const uint64_t f_s[256], Code codes[256]);
+
+// Optimal code lengths with no code longer than max_len bits (package-merge)
+// When plain Huffman already fits, its lengths are returned unchanged
+// max_len: 1..HUF_MAX_LIMIT, or 0 for no limit
+// Returns: number of symbols with nonzero frequency, or -1 if max_len cannot fit them
+int huffmanLimitedCodeLengths(const uint64_t f_s[256], int max_len, unsigned char lens[256]);
+
+// huffmanLimitedCodeLengths followed by huffmanCodesFromLengths
+// Returns: number of symbols with nonzero frequency, or -1 on error
+int huffmanBuildLimitedCodes(const uint64_t f_s[256], int max_len, Code codes[256]);
+
+// Size of the encoded payload in bits (sum of frequency * code length)
+uint64_t huffmanEncodedBits(const uint64_t f_s[256], const Code codes[256]);
 
 // Frees the entire Huffman tree
 void freeHuffmanTree(huffmanNode* root);
@@ -0,0 +1,296 @@
+#define _DEFAULT_SOURCE   // pwritev y posix_madvise con -std=c11
+#include "io.h"
+#include "stats.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+int readAll(int fd, unsigned char *buf, size_t size) {
+    STATS_TIMER(timer);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, buf + done, size - done);
+        STATS_SYSCALL(STAT_SYS_READ);
+        if (n <= 0) { return -1; }
+        done += (size_t)n;
+    }
+    STATS_STOP(timer, STAT_IO, done, 0);
+    return 0;
+}
+
+ssize_t readUpTo(int fd, unsigned char *buf, size_t size) {
+    STATS_TIMER(timer);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, buf + done, size - done);
+        STATS_SYSCALL(STAT_SYS_READ);
+        if (n < 0) { return -1; }
+        if (n == 0) { break; }
+        done += (size_t)n;
+    }
+    STATS_STOP(timer, STAT_IO, done, 0);
+    return (ssize_t)done;
+}
+
+int writeAll(int fd, const unsigned char *buf, size_t size) {
+    STATS_TIMER(timer);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = write(fd, buf + done, size - done);
+        STATS_SYSCALL(STAT_SYS_WRITE);
+        if (n <= 0) { return -1; }
+        done += (size_t)n;
+    }
+    STATS_STOP(timer, STAT_IO, 0, done);
+    return 0;
+}
+
+int readFile(const char *path, unsigned char **data, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    size_t n = (size_t)st.st_size;
+    unsigned char *buf = malloc(n ? n : 1);
+    if (!buf) {
+        close(fd);
+        return -1;
+    }
+    if (readAll(fd, buf, n) != 0) {
+        free(buf);
+        close(fd);
+        return -1;
+    }
+
+    close(fd);
+    *data = buf;
+    *size = n;
+    return 0;
+}
+
+int writeFile(const char *path, const unsigned char *data, size_t size) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    int rc = writeAll(fd, data, size);
+    if (close(fd) != 0) { rc = -1; }
+    return rc;
+}
+
+int pwritevAll(int fd, struct iovec *iov, int iovcnt, off_t offset) {
+    STATS_TIMER(timer);
+    off_t first = offset;
+    while (iovcnt > 0) {
+        int count = iovcnt < ASYNC_WRITER_MAX_IOV ? iovcnt : ASYNC_WRITER_MAX_IOV;
+        ssize_t n = pwritev(fd, iov, count, offset);
+        STATS_SYSCALL(STAT_SYS_PWRITEV);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) {
+            // pwritev devuelve 0 solo si no había nada que escribir.
+            int empty = 1;
+            for (int i = 0; i < count; i++) { empty &= iov[i].iov_len == 0; }
+            if (n < 0 || !empty) { return -1; }
+        }
+        offset += n;
+
+        // Avanza sobre lo escrito; una escritura corta deja un buffer a medias.
+        size_t done = (size_t)(n > 0 ? n : 0);
+        while (iovcnt > 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (unsigned char *)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+    STATS_STOP(timer, STAT_IO, 0, offset - first);
+    return 0;
+}
+
+#define MAP_READ_CHUNK (1u << 20)   // capacidad inicial al leer hasta EOF
+
+// Lee fd hasta EOF en un buffer que crece: el tamaño de fstat no vale para pipes
+// (y otros ficheros especiales informan 0).
+static int readToEnd(int fd, size_t hint, MappedFile *mf) {
+    size_t cap = hint > MAP_READ_CHUNK ? hint : MAP_READ_CHUNK;
+    size_t size = 0;
+    unsigned char *buf = malloc(cap);
+    if (!buf) { return -1; }
+    for (;;) {
+        if (size == cap) {
+            unsigned char *grown = cap <= SIZE_MAX / 2 ? realloc(buf, cap * 2) : NULL;
+            if (!grown) {
+                free(buf);
+                return -1;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t n = readUpTo(fd, buf + size, cap - size);
+        if (n < 0) {
+            free(buf);
+            return -1;
+        }
+        if (n == 0) { break; }
+        size += (size_t)n;
+    }
+    if (size == 0) {
+        free(buf);
+        buf = NULL;
+    }
+    mf->data = buf;
+    mf->size = size;
+    return 0;
+}
+
+int mapFd(int fd, size_t size, MappedFile *mf) {
+    mf->data = NULL;
+    mf->size = size;
+    mf->mapped = 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) { return -1; }
+    if (S_ISREG(st.st_mode) && size > 0) {
+        void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        STATS_SYSCALL(STAT_SYS_MMAP);
+        if (p != MAP_FAILED) {
+            // Lectura secuencial: el kernel agranda el read-ahead y libera las páginas leídas.
+            posix_madvise(p, size, POSIX_MADV_SEQUENTIAL);
+            mf->data = p;
+            mf->mapped = 1;
+            return 0;
+        }
+    }
+    return readToEnd(fd, size, mf);
+}
+
+int mapFile(const char *path, MappedFile *mf) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    int rc = -1;
+    if (fstat(fd, &st) == 0) {
+        rc = mapFd(fd, (size_t)st.st_size, mf);
+    }
+    close(fd);
+    return rc;
+}
+
+void unmapFile(MappedFile *mf) {
+    if (mf->mapped) {
+        munmap(mf->data, mf->size);
+    } else {
+        free(mf->data);
+    }
+    mf->data = NULL;
+    mf->size = 0;
+}
+
+static void *asyncWriterMain(void *arg) {
+    AsyncWriter *aw = arg;
+    pthread_mutex_lock(&aw->lock);
+    for (;;) {
+        while (!aw->busy && !aw->stop) { pthread_cond_wait(&aw->cond, &aw->lock); }
+        if (!aw->busy) { break; }
+        pthread_mutex_unlock(&aw->lock);
+
+        // pwritevAll avanza una copia: las bases originales hacen falta para free().
+        struct iovec pending[ASYNC_WRITER_MAX_IOV];
+        memcpy(pending, aw->iov, (size_t)aw->iovcnt * sizeof *pending);
+        int rc = pwritevAll(aw->fd, pending, aw->iovcnt, aw->job_offset);
+        if (aw->free_after) {
+            for (int i = 0; i < aw->iovcnt; i++) { free(aw->iov[i].iov_base); }
+        }
+
+        pthread_mutex_lock(&aw->lock);
+        if (rc != 0) { aw->error = 1; }
+        aw->busy = 0;
+        pthread_cond_broadcast(&aw->cond);
+    }
+    pthread_mutex_unlock(&aw->lock);
+    return NULL;
+}
+
+int asyncWriterStart(AsyncWriter *aw, int fd, off_t offset) {
+    aw->fd = fd;
+    aw->offset = offset;
+    aw->iovcnt = 0;
+    aw->busy = 0;
+    aw->stop = 0;
+    aw->error = 0;
+    if (pthread_mutex_init(&aw->lock, NULL) != 0) { return -1; }
+    if (pthread_cond_init(&aw->cond, NULL) != 0) {
+        pthread_mutex_destroy(&aw->lock);
+        return -1;
+    }
+    if (pthread_create(&aw->thread, NULL, asyncWriterMain, aw) != 0) {
+        pthread_cond_destroy(&aw->cond);
+        pthread_mutex_destroy(&aw->lock);
+        return -1;
+    }
+    return 0;
+}
+
+int asyncWriterSubmit(AsyncWriter *aw, const struct iovec *iov, int iovcnt, int free_after) {
+    while (iovcnt > 0) {
+        int count = iovcnt < ASYNC_WRITER_MAX_IOV ? iovcnt : ASYNC_WRITER_MAX_IOV;
+        size_t bytes = 0;
+        for (int i = 0; i < count; i++) { bytes += iov[i].iov_len; }
+
+        pthread_mutex_lock(&aw->lock);
+        while (aw->busy) { pthread_cond_wait(&aw->cond, &aw->lock); }
+        memcpy(aw->iov, iov, (size_t)count * sizeof *iov);
+        aw->iovcnt = count;
+        aw->job_offset = aw->offset;
+        aw->free_after = free_after;
+        aw->offset += (off_t)bytes;
+        aw->busy = 1;
+        pthread_cond_broadcast(&aw->cond);
+        pthread_mutex_unlock(&aw->lock);
+
+        iov += count;
+        iovcnt -= count;
+    }
+    pthread_mutex_lock(&aw->lock);
+    int error = aw->error;
+    pthread_mutex_unlock(&aw->lock);
+    return error ? -1 : 0;
+}
+
+int asyncWriterWait(AsyncWriter *aw) {
+    pthread_mutex_lock(&aw->lock);
+    while (aw->busy) { pthread_cond_wait(&aw->cond, &aw->lock); }
+    int error = aw->error;
+    pthread_mutex_unlock(&aw->lock);
+    return error ? -1 : 0;
+}
+
+int asyncWriterFinish(AsyncWriter *aw) {
+    int rc = asyncWriterWait(aw);
+    pthread_mutex_lock(&aw->lock);
+    aw->stop = 1;
+    pthread_cond_broadcast(&aw->cond);
+    pthread_mutex_unlock(&aw->lock);
+    pthread_join(aw->thread, NULL);
+    pthread_cond_destroy(&aw->cond);
+    pthread_mutex_destroy(&aw->lock);
+    return rc;
+}
@@ -0,0 +1,92 @@
+#ifndef IO_H
+#define IO_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#define IO_BUFFER_ALIGN 4096        // alignment of the large output buffers (page size)
+#define ASYNC_WRITER_MAX_IOV 1024   // buffers per pwritev() call (IOV_MAX on Linux)
+
+// Reads exactly size bytes, retrying short reads
+// Returns: 0 on success, -1 on error or early end of file
+int readAll(int fd, unsigned char *buf, size_t size);
+
+// Reads up to size bytes; returns fewer only at end of file
+// Returns: bytes read, or -1 on error
+ssize_t readUpTo(int fd, unsigned char *buf, size_t size);
+
+// Writes exactly size bytes, retrying short writes
+// Returns: 0 on success, -1 on error
+int writeAll(int fd, const unsigned char *buf, size_t size);
+
+// Reads a whole file into a malloc'd buffer (the caller frees *data)
+// Returns: 0 on success, -1 on error
+int readFile(const char *path, unsigned char **data, size_t *size);
+
+// Creates or truncates path and writes data to it
+// Returns: 0 on success, -1 on error
+int writeFile(const char *path, const unsigned char *data, size_t size);
+
+// Writes every buffer of iov at offset with pwritev(), retrying short writes
+// iov is advanced in place; more than ASYNC_WRITER_MAX_IOV buffers take several calls
+// Returns: 0 on success, -1 on error
+int pwritevAll(int fd, struct iovec *iov, int iovcnt, off_t offset);
+
+// Read-only view of a whole file: mmap()ed when possible, read into memory otherwise
+typedef struct MappedFile {
+    unsigned char *data;     // NULL for an empty file
+    size_t size;
+    int mapped;              // 1 = munmap() on release, 0 = free()
+} MappedFile;
+
+// Maps size bytes of fd with a sequential read-ahead hint; fd can be closed afterwards
+// Pipes, special files, empty regular files and files that cannot be mapped are read
+// until EOF instead: size (from fstat) is then only a hint and mf->size is what was read
+// Returns: 0 on success, -1 on error
+int mapFd(int fd, size_t size, MappedFile *mf);
+
+// Opens path and maps it like mapFd
+// Returns: 0 on success, -1 on error
+int mapFile(const char *path, MappedFile *mf);
+
+// Releases a view from mapFd or mapFile
+void unmapFile(MappedFile *mf);
+
+// Background writer: one thread issues pwritev() for a submission while the caller
+// prepares the next one, so I/O overlaps with encoding. At most one submission is
+// in flight; submitting again waits for it.
+typedef struct AsyncWriter {
+    int fd;
+    off_t offset;                             // file offset of the next submitted byte
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct iovec iov[ASYNC_WRITER_MAX_IOV];   // submission in flight
+    int iovcnt;
+    off_t job_offset;
+    int free_after;                           // free() the buffers once written
+    int busy;
+    int stop;
+    int error;
+} AsyncWriter;
+
+// Starts the writer thread; the first submission lands at offset
+// Returns: 0 on success, -1 on error
+int asyncWriterStart(AsyncWriter *aw, int fd, off_t offset);
+
+// Queues iov (copied) to be written at the current offset, which then advances past it
+// free_after: the writer free()s every iov_base once written, even on error
+// Returns: 0 on success, -1 if an earlier write failed
+int asyncWriterSubmit(AsyncWriter *aw, const struct iovec *iov, int iovcnt, int free_after);
+
+// Waits until nothing is in flight
+// Returns: 0 if every write so far succeeded, -1 otherwise
+int asyncWriterWait(AsyncWriter *aw);
+
+// Waits for the last submission and stops the thread
+// Returns: 0 if every write succeeded, -1 otherwise
+int asyncWriterFinish(AsyncWriter *aw);
+
+#endif // IO_H
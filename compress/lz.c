@@ -0,0 +1,389 @@
+#include "lz.h"
+#include "huffman.h"
+#include "bitwriter.h"
+#include "decompress.h"
+#include "histogram.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LZ_BODY_HEADER (4 + 4 + 4 + 256 + 3 * LZ_CODE_SYMBOLS)
+#define LZ_VALUE_CODES 44        // códigos de largo: 0..15 directos, 16..43 potencias de 2
+#define LZ_OFFSET_CODES 32
+
+typedef struct LzLevel {
+    int hash_log;
+    int depth;          // candidatos revisados por posición
+    int lazy;           // 1 = prueba la posición siguiente antes de emitir
+    size_t nice;        // largo suficiente para cortar la búsqueda
+} LzLevel;
+
+static const LzLevel LZ_LEVELS[LZ_MAX_LEVEL + 1] = {
+    {0, 0, 0, 0},
+    {15, 1, 0, 16},      // 1: solo tabla hash, sin cadenas, saltos en zonas sin matches
+    {16, 2, 0, 32},
+    {16, 4, 0, 32},
+    {16, 8, 1, 64},
+    {17, 16, 1, 128},
+    {17, 32, 1, 256},
+    {17, 64, 1, 512},
+    {17, 256, 1, 1024},
+    {17, 1024, 1, 4096},
+};
+
+typedef struct LzSequence {
+    uint32_t lit_len;
+    uint32_t match_len;
+    uint32_t offset;
+} LzSequence;
+
+typedef struct Matcher {
+    const unsigned char *src;
+    size_t n;
+    uint32_t *head;     // posición + 1 por hash, 0 = vacío
+    uint32_t *chain;    // posición anterior con el mismo hash (NULL en el nivel 1)
+    int hash_log;
+    int depth;
+    size_t nice;
+} Matcher;
+
+static inline int highBit(uint32_t v) {
+    return 31 - __builtin_clz(v);
+}
+
+static inline uint32_t read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static inline uint64_t read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static inline uint32_t hash4(const unsigned char *p, int hash_log) {
+    return (read32(p) * 2654435761u) >> (32 - hash_log);
+}
+
+static inline void insertPosition(Matcher *m, size_t pos) {
+    uint32_t h = hash4(m->src + pos, m->hash_log);
+    if (m->chain) { m->chain[pos] = m->head[h]; }
+    m->head[h] = (uint32_t)(pos + 1);
+}
+
+static inline size_t matchLength(const unsigned char *a, const unsigned char *b, const unsigned char *end) {
+    const unsigned char *start = b;
+    while (b + 8 <= end && read64(a) == read64(b)) {
+        a += 8;
+        b += 8;
+    }
+    while (b < end && *a == *b) {
+        a++;
+        b++;
+    }
+    return (size_t)(b - start);
+}
+
+// Mejor match para pos entre las posiciones ya insertadas; 0 si no llega a LZ_MIN_MATCH.
+static size_t findMatch(const Matcher *m, size_t pos, size_t *offset) {
+    const unsigned char *src = m->src;
+    size_t best = LZ_MIN_MATCH - 1;
+    uint32_t cand = m->head[hash4(src + pos, m->hash_log)];
+    for (int depth = m->depth; cand != 0 && depth > 0; depth--) {
+        size_t c = cand - 1;
+        if (pos + best >= m->n) { break; }
+        // Descarta rápido: el candidato debe igualar al menos el byte best.
+        if (src[c + best] == src[pos + best]) {
+            size_t len = matchLength(src + c, src + pos, src + m->n);
+            if (len > best) {
+                best = len;
+                *offset = pos - c;
+                if (len >= m->nice) { break; }
+            }
+        }
+        if (!m->chain) { break; }
+        cand = m->chain[c];
+    }
+    return best >= LZ_MIN_MATCH ? best : 0;
+}
+
+// Parsea src en secuencias y copia los literales contiguos a lits.
+// Returns: número de secuencias; *lit_count recibe el total de literales.
+static size_t parseBlock(Matcher *m, const LzLevel *lv, int level, LzSequence *seqs,
+                         unsigned char *lits, size_t *lit_count) {
+    const unsigned char *src = m->src;
+    const size_t n = m->n;
+    const size_t limit = n >= LZ_MIN_MATCH ? n - LZ_MIN_MATCH + 1 : 0;
+    size_t pos = 0, anchor = 0, count = 0, nlit = 0;
+
+    while (pos < limit) {
+        size_t offset = 0;
+        size_t len = findMatch(m, pos, &offset);
+        insertPosition(m, pos);
+        if (len == 0) {
+            // Nivel 1: el paso crece mientras no aparezcan matches.
+            pos += (level == 1) ? 1 + ((pos - anchor) >> 6) : 1;
+            continue;
+        }
+
+        // Lazy: si la posición siguiente da un match más largo, pos pasa a ser literal.
+        while (lv->lazy && pos + 1 < limit) {
+            size_t offset2 = 0;
+            size_t len2 = findMatch(m, pos + 1, &offset2);
+            if (len2 <= len) { break; }
+            pos++;
+            insertPosition(m, pos);
+            len = len2;
+            offset = offset2;
+        }
+
+        seqs[count].lit_len = (uint32_t)(pos - anchor);
+        seqs[count].match_len = (uint32_t)len;
+        seqs[count].offset = (uint32_t)offset;
+        count++;
+        memcpy(lits + nlit, src + anchor, pos - anchor);
+        nlit += pos - anchor;
+
+        size_t end = pos + len;
+        if (level == 1) {
+            if (end - 2 > pos && end - 2 < limit) { insertPosition(m, end - 2); }
+        } else {
+            for (size_t p = pos + 1; p < end && p < limit; p++) { insertPosition(m, p); }
+        }
+        pos = anchor = end;
+    }
+
+    memcpy(lits + nlit, src + anchor, n - anchor);
+    *lit_count = nlit + (n - anchor);
+    return count;
+}
+
+// Largos: < 16 directos, luego un código por potencia de 2 con highBit bits extra.
+static inline unsigned valueCode(uint32_t v, unsigned *extra) {
+    if (v < 16) {
+        *extra = 0;
+        return v;
+    }
+    *extra = (unsigned)highBit(v);
+    return 12 + *extra;
+}
+
+// Offsets (>= 1): un código por potencia de 2.
+static inline unsigned offsetCode(uint32_t offset, unsigned *extra) {
+    *extra = (unsigned)highBit(offset);
+    return *extra;
+}
+
+// Códigos canónicos; un único símbolo usado recibe un código de 1 bit.
+static int buildStreamCodes(const uint64_t f_s[256], int max_len, Code codes[256]) {
+    if (huffmanBuildLimitedCodes(f_s, max_len, codes) < 0) { return -1; }
+    for (int s = 0; s < 256; s++) {
+        if (f_s[s] > 0 && codes[s].length == 0) {
+            codes[s].bits = 0;
+            codes[s].length = 1;
+        }
+    }
+    return 0;
+}
+
+static inline void writeField(BitWriter *bw, const Code codes[256], unsigned code, uint32_t extra_value,
+                              unsigned extra) {
+    bitWriterWrite(bw, codes[code].bits, (int)codes[code].length);
+    bitWriterWrite(bw, extra_value, (int)extra);
+}
+
+static int encodeSequences(const LzSequence *seqs, size_t count, const unsigned char *lits, size_t nlit,
+                           int max_code_len, unsigned char **out, size_t *out_size) {
+    uint64_t f_lit[256], f_ll[256] = {0}, f_ml[256] = {0}, f_of[256] = {0};
+    uint64_t extra_bits = 0;
+    histogramCount(lits, nlit, f_lit);
+    for (size_t i = 0; i < count; i++) {
+        unsigned extra;
+        f_ll[valueCode(seqs[i].lit_len, &extra)]++;
+        extra_bits += extra;
+        f_ml[valueCode(seqs[i].match_len - LZ_MIN_MATCH, &extra)]++;
+        extra_bits += extra;
+        f_of[offsetCode(seqs[i].offset, &extra)]++;
+        extra_bits += extra;
+    }
+
+    // Los códigos de secuencia caben en una consulta de tabla del decodificador.
+    Code lit_codes[256], ll_codes[256], ml_codes[256], of_codes[256];
+    if (buildStreamCodes(f_lit, max_code_len, lit_codes) != 0 ||
+        buildStreamCodes(f_ll, HUF_TABLE_BITS, ll_codes) != 0 ||
+        buildStreamCodes(f_ml, HUF_TABLE_BITS, ml_codes) != 0 ||
+        buildStreamCodes(f_of, HUF_TABLE_BITS, of_codes) != 0) {
+        return -1;
+    }
+
+    size_t lit_bytes = (size_t)((huffmanEncodedBits(f_lit, lit_codes) + 7) / 8);
+    uint64_t seq_bits = huffmanEncodedBits(f_ll, ll_codes) + huffmanEncodedBits(f_ml, ml_codes) +
+                        huffmanEncodedBits(f_of, of_codes) + extra_bits;
+    size_t seq_bytes = (size_t)((seq_bits + 7) / 8);
+    if (lit_bytes > UINT32_MAX) { return -1; }
+
+    size_t total = 1 + LZ_BODY_HEADER + lit_bytes + seq_bytes;
+    unsigned char *blk = malloc(total);
+    if (!blk) { return -1; }
+
+    unsigned char *p = blk;
+    *p++ = HUF_BLOCK_LZ;
+    uint32_t header[3] = {(uint32_t)nlit, (uint32_t)count, (uint32_t)lit_bytes};
+    memcpy(p, header, sizeof header);
+    p += sizeof header;
+    for (int s = 0; s < 256; s++) { *p++ = (unsigned char)lit_codes[s].length; }
+    for (int s = 0; s < LZ_CODE_SYMBOLS; s++) { *p++ = (unsigned char)ll_codes[s].length; }
+    for (int s = 0; s < LZ_CODE_SYMBOLS; s++) { *p++ = (unsigned char)ml_codes[s].length; }
+    for (int s = 0; s < LZ_CODE_SYMBOLS; s++) { *p++ = (unsigned char)of_codes[s].length; }
+
+    BitWriter bw;
+    bitWriterInitBuffer(&bw, p, lit_bytes);
+    for (size_t i = 0; i < nlit; i++) {
+        bitWriterWrite(&bw, lit_codes[lits[i]].bits, (int)lit_codes[lits[i]].length);
+    }
+    int ok = bitWriterFlush(&bw) >= 0 && bw.out_pos == lit_bytes;
+    p += lit_bytes;
+
+    bitWriterInitBuffer(&bw, p, seq_bytes);
+    for (size_t i = 0; i < count; i++) {
+        unsigned extra, code;
+        code = valueCode(seqs[i].lit_len, &extra);
+        writeField(&bw, ll_codes, code, seqs[i].lit_len - (code < 16 ? code : 1u << extra), extra);
+        uint32_t ml = seqs[i].match_len - LZ_MIN_MATCH;
+        code = valueCode(ml, &extra);
+        writeField(&bw, ml_codes, code, ml - (code < 16 ? code : 1u << extra), extra);
+        code = offsetCode(seqs[i].offset, &extra);
+        writeField(&bw, of_codes, code, seqs[i].offset - (1u << extra), extra);
+    }
+    ok = ok && bitWriterFlush(&bw) >= 0 && bw.out_pos == seq_bytes;
+    if (!ok) {
+        free(blk);
+        return -1;
+    }
+
+    *out = blk;
+    *out_size = total;
+    return 0;
+}
+
+int lzCompressBlock(const unsigned char *src, size_t n, int level, int max_code_len,
+                    unsigned char **out, size_t *out_size) {
+    if (level < 1 || level > LZ_MAX_LEVEL || n > UINT32_MAX) { return -1; }
+    const LzLevel *lv = &LZ_LEVELS[level];
+
+    Matcher m;
+    m.src = src;
+    m.n = n;
+    m.hash_log = lv->hash_log;
+    m.depth = lv->depth;
+    m.nice = lv->nice;
+    m.head = calloc((size_t)1 << lv->hash_log, sizeof(uint32_t));
+    m.chain = (level > 1 && n > 0) ? malloc(n * sizeof(uint32_t)) : NULL;
+    LzSequence *seqs = malloc((n / LZ_MIN_MATCH + 1) * sizeof *seqs);
+    unsigned char *lits = malloc(n ? n : 1);
+
+    int rc = -1;
+    if (m.head && (m.chain || level == 1 || n == 0) && seqs && lits) {
+        size_t nlit;
+        size_t count = parseBlock(&m, lv, level, seqs, lits, &nlit);
+        rc = encodeSequences(seqs, count, lits, nlit, max_code_len, out, out_size);
+    }
+    free(m.head);
+    free(m.chain);
+    free(seqs);
+    free(lits);
+    return rc;
+}
+
+// Lee un código (una consulta de tabla) y sus bits extra; offsets elige el alfabeto.
+static inline int readField(const DecodeTable *t, const unsigned char *src, size_t src_size,
+                            uint64_t *bitpos, int offsets, uint32_t *value) {
+    uint64_t window = loadWindow(src, src_size, *bitpos);
+    const DecodeEntry *e = &t->entries[window >> (64 - HUF_TABLE_BITS)];
+    if (e->count == 0) { return -1; }
+    unsigned code = e->symbols[0];
+    unsigned len = t->lens[code];
+    unsigned extra;
+    uint32_t base;
+    if (offsets) {
+        if (code >= LZ_OFFSET_CODES) { return -1; }
+        extra = code;
+        base = 1u << code;
+    } else {
+        if (code >= LZ_VALUE_CODES) { return -1; }
+        extra = code < 16 ? 0 : code - 12;
+        base = code < 16 ? code : 1u << extra;
+    }
+    *value = base + (extra ? (uint32_t)((window << len) >> (64 - extra)) : 0);
+    *bitpos += len + extra;
+    return 0;
+}
+
+// Copia un match; con offset >= 8 y margen al final copia de a 8 bytes.
+static inline void copyMatch(unsigned char *dst, size_t out, size_t offset, size_t len, size_t n) {
+    unsigned char *to = dst + out;
+    const unsigned char *from = to - offset;
+    if (offset >= 8 && out + len + 8 <= n) {
+        for (size_t i = 0; i < len; i += 8) { memcpy(to + i, from + i, 8); }
+    } else {
+        for (size_t i = 0; i < len; i++) { to[i] = from[i]; }
+    }
+}
+
+static int decodeSequences(DecodeTable *tables, const unsigned char *src, size_t src_size, uint32_t count,
+                           const unsigned char *lits, size_t nlit, unsigned char *dst, size_t n) {
+    uint64_t bitpos = 0;
+    size_t out = 0, lit_pos = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t ll, ml, offset;
+        if (readField(&tables[1], src, src_size, &bitpos, 0, &ll) != 0 ||
+            readField(&tables[2], src, src_size, &bitpos, 0, &ml) != 0 ||
+            readField(&tables[3], src, src_size, &bitpos, 1, &offset) != 0) {
+            return -1;
+        }
+        size_t match = (size_t)ml + LZ_MIN_MATCH;
+        if (ll > nlit - lit_pos || ll > n - out || match > n - out - ll || offset > out + ll) { return -1; }
+        memcpy(dst + out, lits + lit_pos, ll);
+        out += ll;
+        lit_pos += ll;
+        copyMatch(dst, out, offset, match, n);
+        out += match;
+    }
+    if (bitpos > (uint64_t)src_size * 8 || nlit - lit_pos != n - out) { return -1; }
+    memcpy(dst + out, lits + lit_pos, nlit - lit_pos);
+    return 0;
+}
+
+int lzDecompressBlock(const unsigned char *body, size_t body_size, unsigned char *dst, size_t n) {
+    if (body_size < LZ_BODY_HEADER) { return -1; }
+    uint32_t header[3];
+    memcpy(header, body, sizeof header);
+    size_t nlit = header[0], lit_bytes = header[2];
+    if (nlit > n || lit_bytes > body_size - LZ_BODY_HEADER) { return -1; }
+
+    // Tablas: literales y los tres alfabetos de secuencia (rellenados a 256 símbolos).
+    DecodeTable *tables = malloc(4 * sizeof *tables);
+    unsigned char *lits = malloc(nlit ? nlit : 1);
+    int rc = -1;
+    if (tables && lits && buildDecodeTable(&tables[0], body + 12) == 0) {
+        rc = 0;
+        for (int k = 0; k < 3 && rc == 0; k++) {
+            unsigned char lens[256] = {0};
+            memcpy(lens, body + 12 + 256 + k * LZ_CODE_SYMBOLS, LZ_CODE_SYMBOLS);
+            rc = buildDecodeTable(&tables[1 + k], lens);
+            if (rc == 0 && tables[1 + k].max_len > HUF_TABLE_BITS) { rc = -1; }
+        }
+    }
+    if (rc == 0) {
+        rc = huffmanDecode(&tables[0], body + LZ_BODY_HEADER, lit_bytes, lits, nlit);
+    }
+    if (rc == 0) {
+        const unsigned char *seq = body + LZ_BODY_HEADER + lit_bytes;
+        rc = decodeSequences(tables, seq, body_size - LZ_BODY_HEADER - lit_bytes, header[1], lits, nlit, dst, n);
+    }
+    free(tables);
+    free(lits);
+    return rc;
+}
@@ -0,0 +1,35 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// LZ77 front end for HUF2 blocks (HUF_BLOCK_LZ).
+// A block is parsed into sequences (literal run, match length, offset) with a hash-chain
+// match finder. The literals are Huffman coded like a plain block. Each sequence field is
+// mapped to a code (value < 16 literally, then one code per power of two plus extra bits)
+// and those codes get their own canonical Huffman tables.
+// Body: literal_count u32 | sequence_count u32 | literal_bytes u32
+//       | literal lens[256] | literal-length lens[64] | match-length lens[64] | offset lens[64]
+//       | literal bitstream (literal_bytes) | sequence bitstream
+// The sequence bitstream holds, per sequence, literal-length code + extra bits, match-length
+// code + extra bits and offset code + extra bits. Literals left after the last sequence
+// are copied at the end of the block.
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_LEVEL 9
+#define LZ_CODE_SYMBOLS 64
+
+// Parses src and encodes it as an HUF_BLOCK_LZ block (type byte included)
+// level: 1 (fastest, hash table only) .. LZ_MAX_LEVEL (deep chains, lazy matching)
+// max_code_len: longest literal code in bits (0 = unlimited)
+// out: receives the malloc'd block, out_size: its size
+// Returns: 0 on success, -1 on error
+int lzCompressBlock(const unsigned char *src, size_t n, int level, int max_code_len,
+                    unsigned char **out, size_t *out_size);
+
+// Decodes the body of an HUF_BLOCK_LZ block (after the type byte) into exactly n bytes
+// Returns: 0 on success, -1 on corrupt input
+int lzDecompressBlock(const unsigned char *body, size_t body_size, unsigned char *dst, size_t n);
+
+#endif // LZ_H
@@ -5,89 +5,207 @@
 #include <sys/stat.h>
 #include <stdint.h>
 #include <ctype.h> 
+#include <string.h>
 
 #include "huffman.h"
 #include "compress.h"
+#include "decompress.h"
+#include "parallel.h"
+#include "io.h"
+#include "histogram.h"
+#include "huf.h"
+#include "stats.h"
+
+static void dumpStats(void) {
+    statsDump(stderr);
+}
 
-void compute_p_s(double p_s[], int f_s[], const unsigned char* buf, ssize_t nread) {
-    for (size_t i = 0; i < nread; i++) {
-        unsigned char byte = buf[i];   // Leer el valor del byte (0–255)
-        f_s[byte]++;                  // Incrementar el contador.
+int main(int argc, char **argv) {
+    // huffman [-j hilos] [-b bloque] [-m MiB] [-l bits] [-s streams] [-e coder] [-z nivel] [-c] [-k] [-i intervalo] [-S] [input] [output]   comprime (por defecto bible.txt -> bible.huf)
+    // huffman -d [-r offset:longitud] [input] [output]                                                                        descomprime (por defecto bible.huf -> bible.txt)
+    // huffman -t id:tabla [-l bits] [input]                                                                                   entrena un diccionario (por defecto bible.txt)
+    // -j o -b escriben el contenedor HUF2 por bloques en paralelo (-j 0 = todos los núcleos).
+    // -m fija el presupuesto de memoria: entradas más grandes se comprimen en streaming.
+    // -l limita la longitud de los códigos (package-merge), p. ej. 11 para tablas de decodificación en L1.
+    // -s N divide cada bloque HUF2 en N streams intercalados que se decodifican en el mismo bucle.
+    // -z 1..9 activa el LZ77 previo (1 = más rápido, 9 = mejor ratio).
+    // -c prueba por bloque tablas de orden 1 (elegidas por el byte anterior); se quedan donde ganan.
+    // -e auto|huffman|fse elige el codificador de entropía por bloque (auto: tANS si es claramente menor).
+    // -k guarda el CRC32C de los datos (por bloque en HUF2) y se verifica al descomprimir.
+    // -i N añade al HUF1 un índice de saltos con un punto de control cada N bytes (0 = 64 KiB).
+    // -r offset:longitud descomprime solo ese rango (HUF1 desde el punto de control más cercano, HUF2 por bloques).
+    // -t id:tabla guarda en tabla los códigos de la muestra input para los mensajes HUFT (ver huf.h).
+    // -S vuelca al terminar los contadores por etapa en JSON por stderr (compilar con make STATS=1).
+    int decompress = 0;
+    int dump_stats = 0;
+    int parallel = 0;
+    uint32_t seek_interval = 0;
+    int ranged = 0;
+    uint64_t range_offset = 0;
+    size_t range_length = 0;
+    const char *dict_path = NULL;
+    uint32_t dict_id = 0;
+    CompressOptions opts;
+    memset(&opts, 0, sizeof opts);
+    opts.memory_budget = COMPRESS_DEFAULT_MEMORY_BUDGET;
+    const char *paths[2] = {NULL, NULL};
+    int npaths = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0) {
+            decompress = 1;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            opts.threads = atoi(argv[++i]);
+            parallel = 1;
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            opts.block_size = (size_t)strtoull(argv[++i], NULL, 10);
+            parallel = 1;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            opts.memory_budget = (size_t)strtoull(argv[++i], NULL, 10) << 20;
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            opts.max_code_len = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            const char *coder = argv[++i];
+            opts.entropy = strcmp(coder, "huffman") == 0 ? HUF_ENTROPY_HUFFMAN
+                         : strcmp(coder, "fse") == 0     ? HUF_ENTROPY_FSE
+                                                         : HUF_ENTROPY_AUTO;
+            parallel = 1;
+        } else if (strcmp(argv[i], "-z") == 0 && i + 1 < argc) {
+            opts.level = atoi(argv[++i]);
+            parallel = 1;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            opts.context = 1;
+            parallel = 1;
+        } else if (strcmp(argv[i], "-k") == 0) {
+            opts.checksum = 1;
+        } else if (strcmp(argv[i], "-S") == 0) {
+            dump_stats = 1;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            opts.streams = atoi(argv[++i]);
+            parallel = 1;
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            seek_interval = (uint32_t)strtoul(argv[++i], NULL, 10);
+            if (seek_interval == 0) { seek_interval = COMPRESS_DEFAULT_SEEK_INTERVAL; }
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            char *end;
+            range_offset = strtoull(argv[++i], &end, 10);
+            range_length = (size_t)strtoull(*end == ':' ? end + 1 : end, NULL, 10);
+            ranged = 1;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            char *end;
+            dict_id = (uint32_t)strtoul(argv[++i], &end, 10);
+            dict_path = *end == ':' ? end + 1 : end;
+        } else if (npaths < 2) {
+            paths[npaths++] = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [-d] [-j threads] [-b block_size] [-m budget_mib] [-l max_code_len] [-s streams] [-e auto|huffman|fse] [-z level] [-c] [-k] [-i seek_interval] [-r offset:length] [-t id:table] [-S] [input] [output]\n", argv[0]);
+            return 1;
+        }
     }
 
-    for (int i = 0; i < 256; i++) {
-        p_s[i] = (double)f_s[i] / (double)nread;
+    // Se vuelca al salir, por cualquiera de los returns de abajo.
+    if (dump_stats) { atexit(dumpStats); }
+
+    if (decompress) {
+        const char *in_path = paths[0] ? paths[0] : "bible.huf";
+        const char *out_path = paths[1] ? paths[1] : "bible.txt";
+        int rc = ranged ? decompressFileRange(in_path, out_path, range_offset, range_length)
+                        : decompressFile(in_path, out_path);
+        if (rc != 0) {
+            fprintf(stderr, "Error decompressing %s.\n", in_path);
+            return 1;
+        }
+        return 0;
     }
-}
 
-int main(void) {
-    const char *path = "bible.txt";
+    const char *path = paths[0] ? paths[0] : "bible.txt";
+    const char *out_path = paths[1] ? paths[1] : "bible.huf";
 
     int fd = open(path, O_RDONLY);
     if (fd < 0) { perror("open"); return 1; }
 
     struct stat st;
-    if (stat(path, &st) != 0) { perror("stat"); close(fd); return 1; }
-    size_t size = (size_t)st.st_size;
-
-    // Se aloja memoria
-    // SI size es distinto de reserva size bytes, sino 1 para evitar malloc(0)
-    unsigned char *buf = malloc(size ? size : 1);
-    if (!buf) { perror("malloc"); close(fd); return 1; }
-
-    // Escribe datos en el buffer. La variable dice cuantos bytes se copiaron.
-    // Utiliza ssize_t como tipo para almacenar un número correspondiente a la cantidad de bits
-    // File descriptor, puntero donde se copian los bytes leídos, número máximo de bites a leer.
-    ssize_t nread = read(fd, buf, size);
-    
-    if (nread <= 0){ 
-        perror("read"); 
-        free(buf); 
-        close(fd); 
-        return 1; 
+    if (fstat(fd, &st) != 0) { perror("stat"); close(fd); return 1; }
+    uint64_t file_size = (uint64_t)st.st_size;
+
+    // Si no cabe en el presupuesto de memoria se comprime por bloques desde el descriptor.
+    if (file_size > opts.memory_budget) {
+        printf("Streaming %llu bytes\n", (unsigned long long)file_size);
+        int rc = parallel
+            ? compressStreamParallel(fd, file_size, out_path, &opts)
+            : compressStream(fd, out_path, opts.memory_budget / 2, opts.max_code_len, seek_interval,
+                             opts.checksum);
+        if (rc != 0) {
+            fprintf(stderr, "Error writing compressed file.\n");
+        }
+        close(fd);
+        return rc != 0;
+    }
+    size_t size = (size_t)file_size;
+
+    // La entrada se mapea en memoria (sin copiarla desde el page cache) con read-ahead secuencial.
+    MappedFile in;
+    if (mapFd(fd, size, &in) != 0) {
+        perror("mmap");
+        close(fd);
+        return 1;
     }
+    close(fd);
+    const unsigned char *buf = in.data;
+    size_t nread = in.size;
 
     for (size_t i = 0; i < nread && i < 16; i++)
         printf("%02x ", buf[i]);
-    printf("\nRead %zd bytes\n", nread);
-
-    double p_s[256] = {0};
-    int f_s[256] = {0};
-    compute_p_s(p_s, f_s, buf, nread);
-
-    for (int i = 0; i < 256; i++) {
-        if (p_s[i] > 0)
-            printf("Byte %d: %f probs\n", i, p_s[i]);
+    printf("\nRead %zu bytes\n", nread);
+
+    // HUF2 cuenta cada bloque por su cuenta: el histograma global solo lo usan el diccionario y HUF1.
+    if (parallel && !dict_path) {
+        int rc = compressFileParallel(buf, (size_t)nread, out_path, &opts);
+        if (rc != 0) {
+            fprintf(stderr, "Error writing compressed file.\n");
+        }
+        unmapFile(&in);
+        return rc != 0;
     }
 
-    // reservar arreglo de nodos activos (punteros)
-    huffmanNode **activeNodes = malloc(256 * sizeof(huffmanNode *));
-    if (!activeNodes) {
-        perror("malloc activeNodes");
-        free(buf); close(fd);
-        return 1;
+    uint64_t f_s[256];
+    histogramCountParallel(buf, nread, f_s, opts.threads);
+
+    if (dict_path) {
+        HufDict dict;
+        int rc = hufTrainDict(&dict, dict_id, f_s, opts.max_code_len) == 0 ? hufSaveDict(&dict, dict_path) : -1;
+        if (rc != 0) {
+            fprintf(stderr, "Error writing table %s.\n", dict_path);
+        }
+        unmapFile(&in);
+        return rc != 0;
     }
 
-    // Construir árbol Huffman y obtener códigos
+    // Construir códigos canónicos (sin árbol en el heap)
     Code codes[256];
-    huffmanNode *root = huffmanAlgorithm(f_s, activeNodes, codes);
-    if (!root) {
-        fprintf(stderr, "NULL Returned: possible bad file.\n");
-        free(activeNodes);
-        free(buf);
-        close(fd);
+    if (huffmanBuildLimitedCodes(f_s, opts.max_code_len, codes) < 0) {
+        fprintf(stderr, "Invalid code lengths: possible bad file.\n");
+        unmapFile(&in);
         return 1;
     }
 
-    if (compressFile(buf, (size_t)nread, "bible.huf", codes) != 0) {
-        fprintf(stderr, "Error writing compressed file.\n");
+    // Costo del límite de longitud frente a Huffman sin límite.
+    if (opts.max_code_len > 0) {
+        Code unlimited[256];
+        huffmanBuildCodes(f_s, unlimited);
+        uint64_t base = (huffmanEncodedBits(f_s, unlimited) + 7) / 8;
+        uint64_t limited = (huffmanEncodedBits(f_s, codes) + 7) / 8;
+        printf("Length limit %d: %llu bytes vs %llu unlimited (+%.3f%%)\n", opts.max_code_len,
+               (unsigned long long)limited, (unsigned long long)base,
+               base ? 100.0 * (double)(limited - base) / (double)base : 0.0);
     }
 
-    freeHuffmanTree(root);
-    free(activeNodes);
+    int rc = compressFileSeekable(buf, (size_t)nread, out_path, codes, seek_interval, opts.checksum);
+    if (rc != 0) {
+        fprintf(stderr, "Error writing compressed file.\n");
+    }
 
-    free(buf);
-    close(fd);
-    return 0;
+    unmapFile(&in);
+    return rc != 0;
 }
 
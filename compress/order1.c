@@ -0,0 +1,273 @@
+#include "order1.h"
+#include "huffman.h"
+#include "bitwriter.h"
+#include "decompress.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ORDER1_BODY_HEADER(k) (1 + 256 + 256 * (size_t)(k) + 1)
+#define ORDER1_ITERATIONS 4                    // rondas de reasignación de contextos
+#define ORDER1_FAST_STEPS (57 / HUF_TABLE_BITS)
+
+// Estado del codificador: demasiado grande para la pila de un hilo del pool.
+typedef struct Order1Work {
+    uint32_t f[256][256];                      // f[anterior][byte]
+    uint64_t ctx_total[256];
+    unsigned char nz_sym[256][256];            // bytes presentes en cada contexto
+    int nz_count[256];
+    int k;                                     // tablas en uso
+    unsigned char map[256];                    // tabla de cada contexto
+    uint64_t f_s[ORDER1_MAX_TABLES][256];
+    uint32_t cost[ORDER1_MAX_TABLES][256];     // bits por byte en punto fijo Q8
+    Code codes[ORDER1_MAX_TABLES][256];
+} Order1Work;
+
+// log2(v + 1) en punto fijo Q8, lineal entre potencias de 2 (error < 0.09 bits).
+static inline uint32_t log2q8(uint64_t v) {
+    v++;
+    int e = 63 - __builtin_clzll(v);
+    uint64_t frac = e >= 8 ? (v >> (e - 8)) & 0xFF : (v << (8 - e)) & 0xFF;
+    return (uint32_t)e * 256 + (uint32_t)frac;
+}
+
+// Suma los contextos de cada tabla y compacta las que quedaron vacías.
+static void mergeContexts(Order1Work *w) {
+    int remap[ORDER1_MAX_TABLES];
+    memset(w->f_s, 0, sizeof w->f_s);
+    for (int c = 0; c < 256; c++) {
+        for (int i = 0; i < w->nz_count[c]; i++) {
+            int s = w->nz_sym[c][i];
+            w->f_s[w->map[c]][s] += w->f[c][s];
+        }
+    }
+    int k = 0;
+    for (int t = 0; t < w->k; t++) {
+        uint64_t total = 0;
+        for (int s = 0; s < 256; s++) { total += w->f_s[t][s]; }
+        remap[t] = total ? k : 0;
+        if (total && k != t) { memcpy(w->f_s[k], w->f_s[t], sizeof w->f_s[k]); }
+        k += total != 0;
+    }
+    w->k = k ? k : 1;
+    for (int c = 0; c < 256; c++) { w->map[c] = (unsigned char)remap[w->map[c]]; }
+}
+
+// Agrupa los 256 contextos en hasta k_max tablas (k-means sobre el costo de codificación):
+// semillas = los contextos más frecuentes; cada ronda asigna cada contexto a la tabla que
+// lo codifica en menos bits y recalcula las tablas con sus miembros.
+static void clusterContexts(Order1Work *w, int k_max) {
+    int seeds = 0;
+    unsigned char taken[256] = {0};
+    memset(w->map, 0, sizeof w->map);
+    while (seeds < k_max) {
+        int best = -1;
+        for (int c = 0; c < 256; c++) {
+            if (!taken[c] && w->ctx_total[c] > 0 && (best < 0 || w->ctx_total[c] > w->ctx_total[best])) { best = c; }
+        }
+        if (best < 0) { break; }
+        taken[best] = 1;
+        w->map[best] = (unsigned char)seeds++;
+    }
+    w->k = seeds ? seeds : 1;
+
+    // Las semillas arrancan con su propio histograma; el resto se asigna en la primera ronda.
+    memset(w->f_s, 0, sizeof w->f_s);
+    for (int c = 0; c < 256; c++) {
+        if (!taken[c]) { continue; }
+        for (int s = 0; s < 256; s++) { w->f_s[w->map[c]][s] = w->f[c][s]; }
+    }
+
+    for (int round = 0; round < ORDER1_ITERATIONS && w->k > 1; round++) {
+        // Costo de cada byte con +1 en todos los conteos: un byte ausente no es infinito.
+        for (int t = 0; t < w->k; t++) {
+            uint64_t total = 0;
+            for (int s = 0; s < 256; s++) { total += w->f_s[t][s]; }
+            uint32_t base = log2q8(total + 255);
+            for (int s = 0; s < 256; s++) { w->cost[t][s] = base - log2q8(w->f_s[t][s]); }
+        }
+
+        int moved = 0;
+        for (int c = 0; c < 256; c++) {
+            if (w->ctx_total[c] == 0) { continue; }
+            uint64_t best_cost = UINT64_MAX;
+            int best = 0;
+            for (int t = 0; t < w->k; t++) {
+                uint64_t cost = 0;
+                for (int i = 0; i < w->nz_count[c]; i++) {
+                    int s = w->nz_sym[c][i];
+                    cost += (uint64_t)w->f[c][s] * w->cost[t][s];
+                }
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best = t;
+                }
+            }
+            moved |= w->map[c] != best;
+            w->map[c] = (unsigned char)best;
+        }
+        mergeContexts(w);
+        if (!moved && round > 0) { break; }
+    }
+    mergeContexts(w);
+}
+
+int order1CompressBlock(const unsigned char *src, size_t n, int max_code_len, size_t limit,
+                        unsigned char **out, size_t *out_size) {
+    if (n == 0 || n > UINT32_MAX) { return -1; }
+    if (max_code_len <= 0 || max_code_len > HUF_TABLE_BITS) { max_code_len = HUF_TABLE_BITS; }
+
+    Order1Work *w = calloc(1, sizeof *w);
+    if (!w) { return -1; }
+
+    unsigned prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        w->f[prev][src[i]]++;
+        prev = src[i];
+    }
+    for (int c = 0; c < 256; c++) {
+        for (int s = 0; s < 256; s++) {
+            if (w->f[c][s] == 0) { continue; }
+            w->nz_sym[c][w->nz_count[c]++] = (unsigned char)s;
+            w->ctx_total[c] += w->f[c][s];
+        }
+    }
+
+    // Bloques pequeños: cada tabla cuesta 256 bytes de cabecera.
+    size_t k_max = 1 + n / ORDER1_MIN_BYTES_PER_TABLE;
+    clusterContexts(w, k_max < ORDER1_MAX_TABLES ? (int)k_max : ORDER1_MAX_TABLES);
+
+    // Un único símbolo en una tabla recibe un código de 1 bit.
+    uint64_t bits = 0;
+    for (int t = 0; t < w->k; t++) {
+        if (huffmanBuildLimitedCodes(w->f_s[t], max_code_len, w->codes[t]) < 0) {
+            free(w);
+            return -1;
+        }
+        for (int s = 0; s < 256; s++) {
+            if (w->f_s[t][s] > 0 && w->codes[t][s].length == 0) {
+                w->codes[t][s].bits = 0;
+                w->codes[t][s].length = 1;
+            }
+        }
+        bits += huffmanEncodedBits(w->f_s[t], w->codes[t]);
+    }
+
+    // El tamaño exacto se conoce antes de codificar: si no gana no se codifica.
+    size_t header = 1 + ORDER1_BODY_HEADER(w->k);
+    size_t payload = (size_t)((bits + 7) / 8);
+    if (header + payload >= limit) {
+        free(w);
+        return 1;
+    }
+
+    unsigned char *blk = malloc(header + payload);
+    if (!blk) {
+        free(w);
+        return -1;
+    }
+    blk[0] = HUF_BLOCK_ORDER1;
+    blk[1] = (unsigned char)w->k;
+    memcpy(blk + 2, w->map, 256);
+    for (int t = 0; t < w->k; t++) {
+        for (int s = 0; s < 256; s++) { blk[258 + 256 * t + s] = (unsigned char)w->codes[t][s].length; }
+    }
+
+    const Code *table[256];
+    for (int c = 0; c < 256; c++) { table[c] = w->codes[w->map[c]]; }
+
+    BitWriter bw;
+    bitWriterInitBuffer(&bw, blk + header, payload);
+    prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        Code code = table[prev][src[i]];
+        bitWriterWrite(&bw, code.bits, (int)code.length);
+        prev = src[i];
+    }
+    int trailing_bits = bitWriterFlush(&bw);
+    free(w);
+    if (trailing_bits < 0 || bw.out_pos != payload) {
+        free(blk);
+        return -1;
+    }
+    blk[header - 1] = (unsigned char)trailing_bits;
+
+    *out = blk;
+    *out_size = header + payload;
+    return 0;
+}
+
+// Tabla de un símbolo por consulta: byte | longitud << 8 (longitud 0 = código inexistente).
+static int buildOrder1Table(uint16_t *entries, const unsigned char lens[256]) {
+    Code codes[256];
+    if (huffmanCodesFromLengths(lens, codes) < 0) { return -1; }
+    memset(entries, 0, sizeof(uint16_t) << HUF_TABLE_BITS);
+    for (int s = 0; s < 256; s++) {
+        int len = lens[s];
+        if (len == 0) { continue; }
+        if (len > HUF_TABLE_BITS) { return -1; }
+        uint32_t start = (uint32_t)codes[s].bits << (HUF_TABLE_BITS - len);
+        uint32_t end = start + (1u << (HUF_TABLE_BITS - len));
+        for (uint32_t i = start; i < end; i++) { entries[i] = (uint16_t)(s | len << 8); }
+    }
+    return 0;
+}
+
+// Un símbolo: la tabla la elige el byte anterior.
+#define ORDER1_STEP(window)                                                    \
+    do {                                                                       \
+        uint16_t e = table[prev][(window) >> (64 - HUF_TABLE_BITS)];           \
+        if ((e >> 8) == 0) { return -1; }                                      \
+        prev = e & 0xFF;                                                       \
+        dst[out++] = (unsigned char)prev;                                      \
+        consumed += e >> 8;                                                    \
+    } while (0)
+
+static int decodeOrder1(const uint16_t *const table[256], const unsigned char *src, size_t src_size,
+                        unsigned char *dst, size_t n) {
+    const uint64_t total_bits = (uint64_t)src_size * 8;
+    uint64_t bitpos = 0;
+    size_t out = 0;
+    unsigned prev = 0;
+
+    // Camino rápido: cada recarga deja al menos 57 bits, ORDER1_FAST_STEPS códigos completos.
+    while ((size_t)(bitpos >> 3) + 8 <= src_size && out + ORDER1_FAST_STEPS <= n) {
+        uint64_t window = load64be(src + (bitpos >> 3)) << (bitpos & 7);
+        unsigned consumed = 0;
+        for (int step = 0; step < ORDER1_FAST_STEPS; step++) { ORDER1_STEP(window << consumed); }
+        bitpos += consumed;
+    }
+
+    while (out < n) {
+        if (bitpos >= total_bits) { return -1; }
+        unsigned consumed = 0;
+        ORDER1_STEP(loadWindow(src, src_size, bitpos));
+        bitpos += consumed;
+    }
+    return bitpos <= total_bits ? 0 : -1;
+}
+
+int order1DecompressBlock(const unsigned char *body, size_t body_size, unsigned char *dst, size_t n) {
+    if (body_size < 1) { return -1; }
+    int k = body[0];
+    if (k < 1 || k > ORDER1_MAX_TABLES || body_size < ORDER1_BODY_HEADER(k)) { return -1; }
+    const unsigned char *map = body + 1;
+    for (int c = 0; c < 256; c++) {
+        if (map[c] >= k) { return -1; }
+    }
+    if (body[ORDER1_BODY_HEADER(k) - 1] > 7) { return -1; }
+
+    uint16_t *entries = malloc(((size_t)k << HUF_TABLE_BITS) * sizeof *entries);
+    if (!entries) { return -1; }
+    int rc = 0;
+    for (int t = 0; t < k && rc == 0; t++) {
+        rc = buildOrder1Table(entries + ((size_t)t << HUF_TABLE_BITS), body + 257 + 256 * t);
+    }
+    if (rc == 0) {
+        const uint16_t *table[256];
+        for (int c = 0; c < 256; c++) { table[c] = entries + ((size_t)map[c] << HUF_TABLE_BITS); }
+        rc = decodeOrder1(table, body + ORDER1_BODY_HEADER(k), body_size - ORDER1_BODY_HEADER(k), dst, n);
+    }
+    free(entries);
+    return rc;
+}
@@ -0,0 +1,30 @@
+#ifndef ORDER1_H
+#define ORDER1_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Order-1 context-modeled Huffman blocks (HUF_BLOCK_ORDER1).
+// Each byte is coded with a table chosen by the byte before it (0 for the first byte of
+// the block). The 256 previous-byte contexts are clustered into at most ORDER1_MAX_TABLES
+// canonical tables, so the header stays bounded while similar contexts share statistics.
+// Codes are limited to HUF_TABLE_BITS bits: every symbol is one table lookup.
+// Body: table_count u8 | context map u8[256] (table per previous byte)
+//       | lens[256] per table | trailing bits u8 | MSB-first bitstream
+
+#define ORDER1_MAX_TABLES 16
+#define ORDER1_MIN_BYTES_PER_TABLE 8192   // smaller blocks get fewer tables
+
+// Clusters the contexts of src and encodes it as an HUF_BLOCK_ORDER1 block (type byte included)
+// max_code_len: longest code in bits (0 or above HUF_TABLE_BITS = HUF_TABLE_BITS)
+// limit: the block is only encoded if it is smaller than limit bytes
+// out: receives the malloc'd block, out_size: its size
+// Returns: 0 on success, 1 if the block would not be smaller than limit, -1 on error
+int order1CompressBlock(const unsigned char *src, size_t n, int max_code_len, size_t limit,
+                        unsigned char **out, size_t *out_size);
+
+// Decodes the body of an HUF_BLOCK_ORDER1 block (after the type byte) into exactly n bytes
+// Returns: 0 on success, -1 on corrupt input
+int order1DecompressBlock(const unsigned char *body, size_t body_size, unsigned char *dst, size_t n);
+
+#endif // ORDER1_H
@@ -0,0 +1,711 @@
+#include "parallel.h"
+#include "huffman.h"
+#include "bitwriter.h"
+#include "decompress.h"
+#include "io.h"
+#include "histogram.h"
+#include "fse.h"
+#include "lz.h"
+#include "order1.h"
+#include "crc32c.h"
+#include "stats.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define HUF_BLOCK_HUFFMAN_HEADER (1 + 256 + 1)
+#define HUF_BLOCK_FSE_HEADER (1 + 1 + 2 * 256)
+#define HUF_BLOCK_STREAMS_HEADER(n) (1 + 256 + 1 + 4 * ((size_t)(n) - 1))
+#define HUF_SAMPLE_MIN (256 << 10)   // bloques desde este tamaño se prueban antes con una muestra
+#define HUF_SAMPLE_CHUNK 1024        // la muestra: un trozo de cada HUF_SAMPLE_STRIDE
+#define HUF_SAMPLE_STRIDE 8
+
+// ---------------------POOL-----------------------------------------------------------------------
+typedef struct Pool {
+    TaskFn fn;
+    void *ctx;
+    uint32_t tasks;
+    atomic_uint next;      // siguiente tarea libre
+    atomic_int failed;
+} Pool;
+
+static void *poolWorker(void *arg) {
+    Pool *pool = arg;
+    for (;;) {
+        uint32_t t = atomic_fetch_add(&pool->next, 1);
+        if (t >= pool->tasks || atomic_load(&pool->failed)) { break; }
+        if (pool->fn(pool->ctx, t) != 0) { atomic_store(&pool->failed, 1); }
+    }
+    return NULL;
+}
+
+int parallelFor(TaskFn fn, void *ctx, uint32_t tasks, int threads) {
+    Pool pool;
+    pool.fn = fn;
+    pool.ctx = ctx;
+    pool.tasks = tasks;
+    atomic_init(&pool.next, 0);
+    atomic_init(&pool.failed, 0);
+
+    if (threads < 1) { threads = 1; }
+    if ((uint32_t)threads > tasks) { threads = tasks ? (int)tasks : 1; }
+
+    pthread_t *tids = malloc((size_t)threads * sizeof *tids);
+    int started = 0;
+    if (tids) {
+        // Si pthread_create falla se sigue con los hilos que sí arrancaron.
+        while (started < threads - 1 && pthread_create(&tids[started], NULL, poolWorker, &pool) == 0) {
+            started++;
+        }
+    }
+    poolWorker(&pool);
+    for (int i = 0; i < started; i++) { pthread_join(tids[i], NULL); }
+    free(tids);
+
+    return atomic_load(&pool.failed) ? -1 : 0;
+}
+// ------------------------------------------------------------------------------------------------
+
+int defaultThreadCount(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+typedef struct CompressJob {
+    const unsigned char *input;
+    size_t input_size;
+    size_t block_size;
+    int max_code_len;
+    int streams;
+    int entropy;
+    int level;
+    int context;
+    int checksum;
+    unsigned char **blocks;   // bloque comprimido (tipo + cuerpo)
+    size_t *sizes;
+} CompressJob;
+
+// Segmento k de n símbolos repartidos en streams partes (la última puede ser más corta).
+static size_t segmentLength(size_t n, int streams, int k, size_t *start) {
+    size_t seg = (n + (size_t)streams - 1) / (size_t)streams;
+    *start = (size_t)k * seg;
+    if (*start >= n) {
+        *start = n;
+        return 0;
+    }
+    return n - *start < seg ? n - *start : seg;
+}
+
+// Bloque HUF_BLOCK_HUFFMAN_STREAMS: los streams se escriben en el mismo bucle.
+static int encodeStreams(CompressJob *job, uint32_t b, const unsigned char *src, size_t n,
+                         const Code codes[256]) {
+    int streams = job->streams;
+    size_t start[HUF_MAX_STREAMS], len[HUF_MAX_STREAMS], bytes[HUF_MAX_STREAMS];
+    size_t header = HUF_BLOCK_STREAMS_HEADER(streams);
+    size_t total = header;
+    for (int k = 0; k < streams; k++) {
+        uint64_t f_s[256];
+        len[k] = segmentLength(n, streams, k, &start[k]);
+        histogramCount(src + start[k], len[k], f_s);
+        bytes[k] = (size_t)((huffmanEncodedBits(f_s, codes) + 7) / 8);
+        total += bytes[k];
+    }
+
+    unsigned char *out = malloc(total);
+    if (!out) { return -1; }
+    out[0] = HUF_BLOCK_HUFFMAN_STREAMS;
+    for (int s = 0; s < 256; s++) { out[1 + s] = (unsigned char)codes[s].length; }
+    out[257] = (unsigned char)streams;
+
+    BitWriter bw[HUF_MAX_STREAMS];
+    size_t offset = header;
+    for (int k = 0; k < streams; k++) {
+        if (k < streams - 1) {
+            uint32_t size = (uint32_t)bytes[k];
+            memcpy(out + 258 + 4 * k, &size, 4);
+        }
+        bitWriterInitBuffer(&bw[k], out + offset, bytes[k]);
+        offset += bytes[k];
+    }
+
+    // El último segmento es el más corto: hasta su largo avanzan todos juntos.
+    size_t common = len[streams - 1];
+    for (size_t i = 0; i < common; i++) {
+        for (int k = 0; k < streams; k++) {
+            Code code = codes[src[start[k] + i]];
+            bitWriterWrite(&bw[k], code.bits, (int)code.length);
+        }
+    }
+    int rc = 0;
+    for (int k = 0; k < streams; k++) {
+        for (size_t i = common; i < len[k]; i++) {
+            Code code = codes[src[start[k] + i]];
+            bitWriterWrite(&bw[k], code.bits, (int)code.length);
+        }
+        if (bitWriterFlush(&bw[k]) < 0 || bw[k].out_pos != bytes[k]) { rc = -1; }
+    }
+    if (rc != 0) {
+        free(out);
+        return -1;
+    }
+
+    job->blocks[b] = out;
+    job->sizes[b] = total;
+    return 0;
+}
+
+// Bloque HUF_BLOCK_FSE con las frecuencias ya normalizadas.
+static int encodeFse(CompressJob *job, uint32_t b, const unsigned char *src, size_t n,
+                     const uint16_t norm[256], int table_log) {
+    // Cota: a lo sumo table_log bits por símbolo, más los dos estados finales y el centinela.
+    size_t cap = HUF_BLOCK_FSE_HEADER + (size_t)(((uint64_t)n + 2) * (uint64_t)table_log / 8) + 2 + FSE_STREAM_SLACK;
+    unsigned char *out = malloc(cap);
+    if (!out) { return -1; }
+    out[0] = HUF_BLOCK_FSE;
+    out[1] = (unsigned char)table_log;
+    for (int s = 0; s < 256; s++) {
+        out[2 + 2 * s] = (unsigned char)(norm[s] & 0xFF);
+        out[3 + 2 * s] = (unsigned char)(norm[s] >> 8);
+    }
+    size_t payload = fseEncode(norm, table_log, src, n, out + HUF_BLOCK_FSE_HEADER, cap - HUF_BLOCK_FSE_HEADER);
+    if (payload == 0) {
+        free(out);
+        return -1;
+    }
+
+    job->blocks[b] = out;
+    job->sizes[b] = HUF_BLOCK_FSE_HEADER + payload;
+    return 0;
+}
+
+// Bloques HUF_BLOCK_RAW y HUF_BLOCK_RLE: el tipo y los bytes tal cual (RLE: solo el primero).
+static int storeBlock(CompressJob *job, uint32_t b, unsigned char type, const unsigned char *src, size_t n) {
+    size_t size = 1 + (type == HUF_BLOCK_RLE ? 1 : n);
+    unsigned char *out = malloc(size);
+    if (!out) { return -1; }
+    out[0] = type;
+    memcpy(out + 1, src, size - 1);
+
+    job->blocks[b] = out;
+    job->sizes[b] = size;
+    return 0;
+}
+
+// Datos casi uniformes (ya comprimidos o cifrados): Huffman de orden 0 no ahorra ni 1/32.
+static int looksIncompressible(const uint64_t f_s[256], uint64_t total, int max_code_len) {
+    Code codes[256];
+    if (total == 0 || huffmanBuildLimitedCodes(f_s, max_code_len, codes) < 0) { return 0; }
+    return huffmanEncodedBits(f_s, codes) + total / 4 >= total * 8;
+}
+
+static int encodeBlock(CompressJob *job, uint32_t b, const unsigned char *src, size_t n) {
+    uint64_t f_s[256];
+
+    // Bloques grandes sin LZ77 ni contexto: si una muestra ya parece incompresible se guardan
+    // sin contar el resto. Con ellos no: un histograma plano aún puede tener repeticiones.
+    if (job->level == 0 && !job->context && n >= HUF_SAMPLE_MIN) {
+        uint64_t sampled = 0;
+        memset(f_s, 0, sizeof f_s);
+        for (size_t off = 0; off + HUF_SAMPLE_CHUNK <= n; off += HUF_SAMPLE_CHUNK * HUF_SAMPLE_STRIDE) {
+            histogramAdd(src + off, HUF_SAMPLE_CHUNK, f_s);
+            sampled += HUF_SAMPLE_CHUNK;
+        }
+        if (looksIncompressible(f_s, sampled, job->max_code_len)) {
+            return storeBlock(job, b, HUF_BLOCK_RAW, src, n);
+        }
+    }
+
+    histogramCount(src, n, f_s);
+
+    // Un solo símbolo: Huffman le daría longitud 0 y no emitiría nada.
+    int used = 0;
+    for (int s = 0; s < 256; s++) { used += f_s[s] != 0; }
+    if (used == 1) { return storeBlock(job, b, HUF_BLOCK_RLE, src, n); }
+
+    Code codes[256];
+    if (huffmanBuildLimitedCodes(f_s, job->max_code_len, codes) < 0) { return -1; }
+
+    // El tamaño exacto del bitstream se conoce por el histograma.
+    size_t payload = (size_t)((huffmanEncodedBits(f_s, codes) + 7) / 8);
+
+    // tANS gana en distribuciones sesgadas, donde Huffman pierde hasta un bit por símbolo;
+    // como decodifica más lento, solo se elige si ahorra al menos 1/32 del bloque Huffman.
+    size_t order0_size = HUF_BLOCK_HUFFMAN_HEADER + payload;
+    int use_fse = 0, table_log = 0;
+    uint16_t norm[256];
+    if (job->entropy != HUF_ENTROPY_HUFFMAN) {
+        table_log = fseTableLog(n, used);
+        if (fseNormalizeCounts(f_s, table_log, norm) > 0) {
+            size_t huf_size = HUF_BLOCK_HUFFMAN_HEADER + payload;
+            size_t fse_size = HUF_BLOCK_FSE_HEADER + (size_t)(fseEncodedBits(f_s, norm, table_log) / 8) + 4;
+            if (job->entropy == HUF_ENTROPY_FSE || fse_size + huf_size / 32 < huf_size) {
+                use_fse = 1;
+                order0_size = fse_size;
+            }
+        }
+    }
+
+    // Si orden 0 no ahorra al menos 1/32 se guarda crudo: se decodifica con un memcpy.
+    size_t raw_size = 1 + n;
+    int use_raw = order0_size + raw_size / 32 >= raw_size;
+    if (use_raw) { order0_size = raw_size; }
+
+    // Orden 1 solo se codifica si su tamaño, conocido de antemano, mejora al de orden 0.
+    unsigned char *best = NULL;
+    size_t best_size = order0_size;
+    if (job->context) {
+        int rc = order1CompressBlock(src, n, job->max_code_len, best_size, &best, &best_size);
+        if (rc < 0) { return -1; }
+    }
+
+    // LZ77 solo se queda si mejora a lo anterior (p. ej. no en datos aleatorios).
+    if (job->level > 0) {
+        unsigned char *lz;
+        size_t lz_size;
+        if (lzCompressBlock(src, n, job->level, job->max_code_len, &lz, &lz_size) != 0) {
+            free(best);
+            return -1;
+        }
+        if (lz_size < best_size) {
+            free(best);
+            best = lz;
+            best_size = lz_size;
+        } else {
+            free(lz);
+        }
+    }
+    if (best) {
+        job->blocks[b] = best;
+        job->sizes[b] = best_size;
+        return 0;
+    }
+
+    if (use_raw) { return storeBlock(job, b, HUF_BLOCK_RAW, src, n); }
+
+    if (use_fse) { return encodeFse(job, b, src, n, norm, table_log); }
+
+    if (job->streams > 1) { return encodeStreams(job, b, src, n, codes); }
+
+    unsigned char *out = malloc(HUF_BLOCK_HUFFMAN_HEADER + payload);
+    if (!out) { return -1; }
+    out[0] = HUF_BLOCK_HUFFMAN;
+    for (int s = 0; s < 256; s++) { out[1 + s] = (unsigned char)codes[s].length; }
+
+    BitWriter bw;
+    bitWriterInitBuffer(&bw, out + HUF_BLOCK_HUFFMAN_HEADER, payload);
+    for (size_t i = 0; i < n; i++) {
+        Code code = codes[src[i]];
+        bitWriterWrite(&bw, code.bits, (int)code.length);
+    }
+    int trailing_bits = bitWriterFlush(&bw);
+    if (trailing_bits < 0 || bw.out_pos != payload) {
+        free(out);
+        return -1;
+    }
+    out[257] = (unsigned char)trailing_bits;
+
+    job->blocks[b] = out;
+    job->sizes[b] = HUF_BLOCK_HUFFMAN_HEADER + payload;
+    return 0;
+}
+
+static int compressBlock(void *arg, uint32_t b) {
+    CompressJob *job = arg;
+    const unsigned char *src = job->input + (size_t)b * job->block_size;
+    size_t n = job->input_size - (size_t)b * job->block_size;
+    if (n > job->block_size) { n = job->block_size; }
+    STATS_TIMER(timer);
+    if (!job->checksum) {
+        int rc = encodeBlock(job, b, src, n);
+        STATS_STOP(timer, STAT_ENCODE, n, rc == 0 ? job->sizes[b] : 0);
+        return rc;
+    }
+
+    // El CRC deja el bloque en caché para el histograma y la codificación que siguen.
+    uint32_t crc = crc32cUpdate(0, src, n);
+    if (encodeBlock(job, b, src, n) != 0) { return -1; }
+    unsigned char *blk = realloc(job->blocks[b], job->sizes[b] + sizeof crc);
+    if (!blk) { return -1; }
+    blk[0] |= HUF_BLOCK_FLAG_CRC;
+    memcpy(blk + job->sizes[b], &crc, sizeof crc);
+    job->blocks[b] = blk;
+    job->sizes[b] += sizeof crc;
+    STATS_STOP(timer, STAT_ENCODE, n, job->sizes[b]);
+    return 0;
+}
+
+// Comprime un lote de bloques en paralelo y lo entrega al writer, que lo escribe con
+// pwritev() mientras se comprime el lote siguiente; anota los offsets de cada bloque.
+static int runBatch(CompressJob *job, uint32_t count, int threads) {
+    int rc = parallelFor(compressBlock, job, count, threads);
+    if (rc != 0) {
+        for (uint32_t b = 0; b < count; b++) {
+            free(job->blocks[b]);
+            job->blocks[b] = NULL;
+        }
+    }
+    return rc;
+}
+
+static int writeBatch(AsyncWriter *aw, CompressJob *job, uint32_t count, int threads,
+                      uint64_t *index, uint64_t *offset) {
+    int rc = runBatch(job, count, threads);
+    if (rc != 0) {
+        return rc;
+    }
+
+    struct iovec iov[ASYNC_WRITER_MAX_IOV];
+    for (uint32_t first = 0; rc == 0 && first < count; first += ASYNC_WRITER_MAX_IOV) {
+        int n = count - first < ASYNC_WRITER_MAX_IOV ? (int)(count - first) : ASYNC_WRITER_MAX_IOV;
+        for (int i = 0; i < n; i++) {
+            uint32_t b = first + (uint32_t)i;
+            index[b] = *offset;
+            *offset += job->sizes[b];
+            iov[i].iov_base = job->blocks[b];
+            iov[i].iov_len = job->sizes[b];
+            job->blocks[b] = NULL;   // ahora es del writer
+        }
+        rc = asyncWriterSubmit(aw, iov, n, 1);
+    }
+    return rc;
+}
+
+// Rellena los valores por defecto de las opciones (opts puede ser NULL).
+static CompressOptions resolveOptions(const CompressOptions *opts) {
+    CompressOptions o;
+    memset(&o, 0, sizeof o);
+    if (opts) { o = *opts; }
+    if (o.block_size == 0) { o.block_size = HUF2_DEFAULT_BLOCK_SIZE; }
+    if (o.threads <= 0) { o.threads = defaultThreadCount(); }
+    if (o.memory_budget == 0) { o.memory_budget = COMPRESS_DEFAULT_MEMORY_BUDGET; }
+    return o;
+}
+
+// Opciones ya resueltas que el formato y los codificadores admiten para input_size bytes.
+static int validOptions(const CompressOptions *opts, uint64_t input_size) {
+    return opts->block_size <= UINT32_MAX && input_size <= SIZE_MAX && opts->max_code_len <= HUF_MAX_LIMIT &&
+           opts->streams <= HUF_MAX_STREAMS && opts->entropy >= 0 && opts->entropy <= HUF_ENTROPY_FSE &&
+           opts->level >= 0 && opts->level <= LZ_MAX_LEVEL &&
+           huf2BlockCount(input_size, opts->block_size) <= UINT32_MAX - 1;
+}
+
+uint64_t huf2BlockCount(uint64_t input_size, size_t block_size) {
+    return (input_size + block_size - 1) / block_size;
+}
+
+void huf2Header(unsigned char header[HUF2_HEADER_SIZE], uint64_t input_size, uint32_t block_size,
+                uint32_t block_count) {
+    memcpy(header, "HUF2", 4);
+    memcpy(header + 4, &input_size, 8);
+    memcpy(header + 12, &block_size, 4);
+    memcpy(header + 16, &block_count, 4);
+}
+
+int compressBlocks(const unsigned char *input, size_t input_size, const CompressOptions *opts,
+                   unsigned char **blocks, size_t *sizes) {
+    CompressOptions o = resolveOptions(opts);
+    if (!validOptions(&o, input_size)) { return -1; }
+
+    CompressJob job;
+    job.input = input;
+    job.input_size = input_size;
+    job.block_size = o.block_size;
+    job.max_code_len = o.max_code_len;
+    job.streams = o.streams;
+    job.entropy = o.entropy;
+    job.level = o.level;
+    job.context = o.context;
+    job.checksum = o.checksum;
+    job.blocks = blocks;
+    job.sizes = sizes;
+    uint32_t count = (uint32_t)huf2BlockCount(input_size, o.block_size);
+    for (uint32_t b = 0; b < count; b++) { blocks[b] = NULL; }
+    return runBatch(&job, count, o.threads);
+}
+
+// Escribe un HUF2 completo. La entrada viene de memoria (input) o se lee de in_fd
+// de a batch_blocks bloques, así la memoria queda acotada por el lote.
+static int writeHuf2(int fd, const unsigned char *input, int in_fd, uint64_t input_size,
+                     const CompressOptions *opts, uint32_t batch_blocks) {
+    size_t block_size = opts->block_size;
+    int threads = opts->threads;
+    if (!validOptions(opts, input_size)) { return -1; }
+
+    uint32_t block_count = (uint32_t)huf2BlockCount(input_size, block_size);
+    if (batch_blocks == 0) { batch_blocks = 1; }
+    if (batch_blocks > block_count) { batch_blocks = block_count ? block_count : 1; }
+
+    CompressJob job;
+    job.block_size = block_size;
+    job.max_code_len = opts->max_code_len;
+    job.streams = opts->streams;
+    job.entropy = opts->entropy;
+    job.level = opts->level;
+    job.context = opts->context;
+    job.checksum = opts->checksum;
+    job.blocks = calloc(batch_blocks, sizeof *job.blocks);
+    job.sizes = calloc(batch_blocks, sizeof *job.sizes);
+    uint64_t *index = malloc(((size_t)block_count + 1) * sizeof *index);
+    unsigned char *buf = NULL;
+    if (!input) { buf = malloc((size_t)batch_blocks * block_size); }
+
+    int rc = -1;
+    if (job.blocks && job.sizes && index && (input || buf)) {
+        // Los bloques van detrás del índice; cabecera e índice se escriben al final,
+        // cuando se conocen los offsets, con un solo pwritev().
+        unsigned char header[HUF2_HEADER_SIZE];
+        huf2Header(header, input_size, (uint32_t)block_size, block_count);
+
+        size_t index_bytes = ((size_t)block_count + 1) * sizeof *index;
+        uint64_t offset = HUF2_HEADER_SIZE + index_bytes;
+        AsyncWriter aw;
+        int started = asyncWriterStart(&aw, fd, (off_t)offset) == 0;
+        rc = started ? 0 : -1;
+
+        for (uint32_t first = 0; rc == 0 && first < block_count; first += batch_blocks) {
+            uint32_t n = block_count - first < batch_blocks ? block_count - first : batch_blocks;
+            uint64_t pos = (uint64_t)first * block_size;
+            size_t bytes = (size_t)(input_size - pos < (uint64_t)n * block_size ? input_size - pos
+                                                                               : (uint64_t)n * block_size);
+            if (input) {
+                job.input = input + pos;
+            } else {
+                if (readUpTo(in_fd, buf, bytes) != (ssize_t)bytes) { rc = -1; break; }
+                job.input = buf;
+            }
+            job.input_size = bytes;
+            rc = writeBatch(&aw, &job, n, threads, index + first, &offset);
+        }
+        index[block_count] = offset;
+        if (started && asyncWriterFinish(&aw) != 0) { rc = -1; }
+
+        if (rc == 0) {
+            struct iovec iov[2] = {{header, sizeof header}, {index, index_bytes}};
+            rc = pwritevAll(fd, iov, 2, 0);
+        }
+    }
+
+    free(buf);
+    free(job.blocks);
+    free(job.sizes);
+    free(index);
+    return rc;
+}
+
+int compressFileParallel(const unsigned char *input, size_t input_size, const char *output_path,
+                         const CompressOptions *opts) {
+    CompressOptions o = resolveOptions(opts);
+    int fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    // Lotes de varios bloques por hilo: acota la memoria de los bloques comprimidos.
+    int rc = writeHuf2(fd, input, -1, (uint64_t)input_size, &o, (uint32_t)o.threads * 8);
+    if (close(fd) != 0) { rc = -1; }
+    return rc;
+}
+
+int compressStreamParallel(int in_fd, uint64_t input_size, const char *output_path,
+                           const CompressOptions *opts) {
+    CompressOptions o = resolveOptions(opts);
+
+    // Un tercio del presupuesto para la entrada del lote y el resto para los bloques
+    // comprimidos: los del lote actual y los del anterior, que el writer sigue escribiendo.
+    size_t batch = o.memory_budget / 3 / o.block_size;
+    if (batch == 0) { batch = 1; }
+    if (batch > UINT32_MAX) { batch = UINT32_MAX; }
+
+    int fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    int rc = writeHuf2(fd, NULL, in_fd, input_size, &o, (uint32_t)batch);
+    if (close(fd) != 0) { rc = -1; }
+    return rc;
+}
+
+typedef struct DecompressJob {
+    const unsigned char *in;
+    uint64_t index_offset;
+    size_t block_size;
+    uint64_t original_size;
+    uint32_t first;          // tarea t decodifica el bloque first + t
+    unsigned char *out;      // salida del bloque first
+} DecompressJob;
+
+// Cuerpo de HUF_BLOCK_HUFFMAN_STREAMS: tabla de saltos y luego los streams seguidos.
+static int decodeStreamsBlock(const DecodeTable *table, const unsigned char *blk, size_t blk_size,
+                              unsigned char *dst, size_t n) {
+    int streams = blk[257];
+    if (streams < 2 || streams > HUF_MAX_STREAMS || blk_size < HUF_BLOCK_STREAMS_HEADER(streams)) {
+        return -1;
+    }
+
+    const unsigned char *src[HUF_MAX_STREAMS];
+    size_t src_size[HUF_MAX_STREAMS];
+    unsigned char *out[HUF_MAX_STREAMS];
+    size_t out_size[HUF_MAX_STREAMS];
+    size_t offset = HUF_BLOCK_STREAMS_HEADER(streams);
+    for (int k = 0; k < streams; k++) {
+        if (k < streams - 1) {
+            uint32_t size;
+            memcpy(&size, blk + 258 + 4 * k, 4);
+            src_size[k] = size;
+        } else {
+            src_size[k] = blk_size - offset;
+        }
+        if (src_size[k] > blk_size - offset) { return -1; }
+        src[k] = blk + offset;
+        offset += src_size[k];
+
+        size_t start;
+        out_size[k] = segmentLength(n, streams, k, &start);
+        out[k] = dst + start;
+    }
+    return huffmanDecodeStreams(table, streams, src, src_size, out, out_size);
+}
+
+// Cuerpo de HUF_BLOCK_FSE: table_log, frecuencias normalizadas u16 y el stream.
+static int decodeFseBlock(const unsigned char *blk, size_t blk_size, unsigned char *dst, size_t n) {
+    if (blk_size < HUF_BLOCK_FSE_HEADER) { return -1; }
+    uint16_t norm[256];
+    for (int s = 0; s < 256; s++) {
+        norm[s] = (uint16_t)(blk[2 + 2 * s] | (blk[3 + 2 * s] << 8));
+    }
+    return fseDecode(norm, blk[1], blk + HUF_BLOCK_FSE_HEADER, blk_size - HUF_BLOCK_FSE_HEADER, dst, n);
+}
+
+// Cuerpo de un bloque de tipo type (blk[0], sin el flag de CRC) en exactamente n bytes.
+static int decodeBlock(const unsigned char *blk, size_t blk_size, unsigned type, unsigned char *dst, size_t n) {
+    if (blk_size >= 1 && type == HUF_BLOCK_RAW) {
+        if (blk_size - 1 != n) { return -1; }
+        memcpy(dst, blk + 1, n);
+        return 0;
+    }
+    if (blk_size == 2 && type == HUF_BLOCK_RLE) {
+        memset(dst, blk[1], n);
+        return 0;
+    }
+    if (blk_size >= 2 && type == HUF_BLOCK_FSE) { return decodeFseBlock(blk, blk_size, dst, n); }
+    if (blk_size >= 1 && type == HUF_BLOCK_ORDER1) { return order1DecompressBlock(blk + 1, blk_size - 1, dst, n); }
+    if (blk_size >= 1 && type == HUF_BLOCK_LZ) { return lzDecompressBlock(blk + 1, blk_size - 1, dst, n); }
+    if (blk_size < HUF_BLOCK_HUFFMAN_HEADER) { return -1; }
+    if (type == HUF_BLOCK_HUFFMAN && blk[257] > 7) { return -1; }
+    if (type != HUF_BLOCK_HUFFMAN && type != HUF_BLOCK_HUFFMAN_STREAMS) { return -1; }
+
+    DecodeTable *table = malloc(sizeof *table);
+    if (!table) { return -1; }
+    int rc = buildDecodeTable(table, blk + 1);
+    if (rc == 0 && type == HUF_BLOCK_HUFFMAN) {
+        rc = huffmanDecode(table, blk + HUF_BLOCK_HUFFMAN_HEADER, blk_size - HUF_BLOCK_HUFFMAN_HEADER, dst, n);
+    } else if (rc == 0) {
+        rc = decodeStreamsBlock(table, blk, blk_size, dst, n);
+    }
+    free(table);
+    return rc;
+}
+
+static int decompressBlock(void *arg, uint32_t task) {
+    DecompressJob *job = arg;
+    uint32_t b = job->first + task;
+    uint64_t start, end;
+    memcpy(&start, job->in + job->index_offset + (uint64_t)b * 8, 8);
+    memcpy(&end, job->in + job->index_offset + ((uint64_t)b + 1) * 8, 8);
+
+    const unsigned char *blk = job->in + start;
+    size_t blk_size = (size_t)(end - start);
+    unsigned char *dst = job->out + (size_t)task * job->block_size;
+    uint64_t left = job->original_size - (uint64_t)b * job->block_size;
+    size_t n = left < job->block_size ? (size_t)left : job->block_size;
+
+    // El índice admite bloques vacíos (start == end): no hay ni byte de tipo que leer.
+    if (blk_size == 0) { return -1; }
+
+    // Con HUF_BLOCK_FLAG_CRC el bloque decodificado se verifica mientras sigue en caché.
+    STATS_TIMER(timer);
+    uint32_t crc;
+    if (blk_size < 1 + sizeof crc || !(blk[0] & HUF_BLOCK_FLAG_CRC)) {
+        int rc = decodeBlock(blk, blk_size, blk[0], dst, n);
+        STATS_STOP(timer, STAT_DECODE, blk_size, n);
+        return rc;
+    }
+    blk_size -= sizeof crc;
+    memcpy(&crc, blk + blk_size, sizeof crc);
+    if (decodeBlock(blk, blk_size, blk[0] & ~HUF_BLOCK_FLAG_CRC, dst, n) != 0) { return -1; }
+    STATS_STOP(timer, STAT_DECODE, blk_size + sizeof crc, n);
+    return crc32cUpdate(0, dst, n) == crc ? 0 : -1;
+}
+
+// Valida cabecera e índice de un HUF2 y prepara job para decodificar desde el bloque 0.
+// Returns: número de bloques, o -1 si el contenedor está corrupto.
+static int64_t openHuf2(const unsigned char *in, size_t in_size, DecompressJob *job) {
+    if (in_size < HUF2_HEADER_SIZE || memcmp(in, "HUF2", 4) != 0) { return -1; }
+
+    uint64_t original_size;
+    uint32_t block_size, block_count;
+    memcpy(&original_size, in + 4, 8);
+    memcpy(&block_size, in + 12, 4);
+    memcpy(&block_count, in + 16, 4);
+    if (block_size == 0 || (uint64_t)block_count != (original_size + block_size - 1) / block_size) {
+        return -1;
+    }
+
+    // El índice debe caber en el archivo y ser monótono antes de repartir bloques.
+    uint64_t index_offset = HUF2_HEADER_SIZE;
+    uint64_t index_end = index_offset + ((uint64_t)block_count + 1) * 8;
+    if (index_end > in_size) { return -1; }
+    uint64_t prev = index_end;
+    for (uint32_t b = 0; b <= block_count; b++) {
+        uint64_t off;
+        memcpy(&off, in + index_offset + (uint64_t)b * 8, 8);
+        if (off < prev || off > in_size) { return -1; }
+        prev = off;
+    }
+
+    job->in = in;
+    job->index_offset = index_offset;
+    job->block_size = block_size;
+    job->original_size = original_size;
+    job->first = 0;
+    job->out = NULL;
+    return block_count;
+}
+
+int decompressBlocks(const unsigned char *in, size_t in_size, unsigned char *out, size_t out_size,
+                     int threads) {
+    DecompressJob job;
+    int64_t block_count = openHuf2(in, in_size, &job);
+    if (block_count < 0 || job.original_size != out_size) { return -1; }
+
+    job.out = out;
+    if (threads <= 0) { threads = defaultThreadCount(); }
+    return parallelFor(decompressBlock, &job, (uint32_t)block_count, threads);
+}
+
+int decompressBlocksRange(const unsigned char *in, size_t in_size, uint64_t offset, size_t length,
+                          unsigned char *dst, int threads) {
+    DecompressJob job;
+    int64_t block_count = openHuf2(in, in_size, &job);
+    if (block_count < 0 || offset > job.original_size || length > job.original_size - offset) { return -1; }
+    if (length == 0) { return 0; }
+
+    // Solo los bloques que tocan el rango, en un buffer temporal.
+    uint64_t first = offset / job.block_size;
+    uint64_t last = (offset + length - 1) / job.block_size;
+    uint64_t span_end = (last + 1) * job.block_size;
+    if (span_end > job.original_size) { span_end = job.original_size; }
+    size_t span = (size_t)(span_end - first * job.block_size);
+    unsigned char *tmp = malloc(span);
+    if (!tmp) { return -1; }
+
+    job.first = (uint32_t)first;
+    job.out = tmp;
+    if (threads <= 0) { threads = defaultThreadCount(); }
+    int rc = parallelFor(decompressBlock, &job, (uint32_t)(last - first + 1), threads);
+    if (rc == 0) { memcpy(dst, tmp + (offset - first * job.block_size), length); }
+    free(tmp);
+    return rc;
+}
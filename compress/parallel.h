@@ -0,0 +1,100 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// HUF2 container: independent blocks, each with its own code lengths
+//   "HUF2" | original_size u64 | block_size u32 | block_count u32
+//   | block offsets u64[block_count + 1] (from file start, last = end of file)
+//   | blocks
+// Every block starts with a type byte followed by its type-specific body.
+// With HUF_BLOCK_FLAG_CRC set in the type byte, the block ends with the CRC32C (u32)
+// of its decoded bytes, checked as each block is decoded.
+
+#define HUF2_HEADER_SIZE (4 + 8 + 4 + 4)
+#define HUF2_DEFAULT_BLOCK_SIZE (1 << 20)
+#define COMPRESS_DEFAULT_MEMORY_BUDGET ((size_t)1 << 30)
+
+#define HUF_BLOCK_HUFFMAN 0          // lens[256] | trailing bits | bitstream
+#define HUF_BLOCK_HUFFMAN_STREAMS 1  // lens[256] | streams | stream sizes u32[streams - 1] | bitstreams
+                                     // stream k holds the k-th of streams equal slices of the block
+#define HUF_BLOCK_FSE 2              // table_log | normalized counts u16[256] (LE) | tANS stream (see fse.h)
+#define HUF_BLOCK_LZ 3               // LZ77 sequences with Huffman-coded literals and codes (see lz.h)
+#define HUF_BLOCK_RAW 4              // the block bytes, stored unchanged (incompressible data)
+#define HUF_BLOCK_RLE 5              // one byte, repeated over the whole block
+#define HUF_BLOCK_ORDER1 6           // Huffman tables selected by the previous byte (see order1.h)
+#define HUF_BLOCK_FLAG_CRC 0x80
+
+// Entropy coder choice for CompressOptions.entropy
+#define HUF_ENTROPY_AUTO 0           // per block, tANS when it is clearly smaller than Huffman
+#define HUF_ENTROPY_HUFFMAN 1
+#define HUF_ENTROPY_FSE 2
+
+// Number of online cores, at least 1
+int defaultThreadCount(void);
+
+typedef int (*TaskFn)(void *ctx, uint32_t task);
+
+// Runs fn(ctx, 0..tasks-1) on up to threads threads, the caller included
+// Returns: 0 if every task returned 0, -1 otherwise (remaining tasks are skipped)
+int parallelFor(TaskFn fn, void *ctx, uint32_t tasks, int threads);
+
+// Options for the HUF2 compressors; a zeroed struct (or NULL) selects the defaults
+typedef struct CompressOptions {
+    size_t block_size;       // uncompressed bytes per block (0 = HUF2_DEFAULT_BLOCK_SIZE)
+    int threads;             // worker threads (0 = defaultThreadCount())
+    size_t memory_budget;    // streaming: bytes for input and output batches (0 = COMPRESS_DEFAULT_MEMORY_BUDGET)
+    int max_code_len;        // longest code in bits, 1..HUF_MAX_LIMIT (0 = unlimited)
+    int streams;             // interleaved bitstreams per block, 2..HUF_MAX_STREAMS (0 or 1 = single stream)
+    int entropy;             // HUF_ENTROPY_AUTO, HUF_ENTROPY_HUFFMAN or HUF_ENTROPY_FSE (tANS blocks are single stream)
+    int level;               // LZ77 front end, 1 (fastest)..LZ_MAX_LEVEL (0 = off); kept only where it wins
+    int context;             // 1 = also try order-1 context modeling per block; kept only where it wins
+    int checksum;            // 1 = store a CRC32C per block (HUF_BLOCK_FLAG_CRC)
+} CompressOptions;
+
+// Number of blocks of a HUF2 container holding input_size bytes
+uint64_t huf2BlockCount(uint64_t input_size, size_t block_size);
+
+// Fills the fixed HUF2 header; the block offsets follow it
+void huf2Header(unsigned char header[HUF2_HEADER_SIZE], uint64_t input_size, uint32_t block_size,
+                uint32_t block_count);
+
+// Compresses every block of input on a pool of threads, without writing anything
+// blocks[b], sizes[b]: receive block b (type byte and body, malloc'd; the caller frees them)
+// and must have room for huf2BlockCount(input_size, block_size) entries
+// Returns: 0 on success, -1 on error (then no block is left allocated)
+int compressBlocks(const unsigned char *input, size_t input_size, const CompressOptions *opts,
+                   unsigned char **blocks, size_t *sizes);
+
+// Compress data into a HUF2 container, one block per task on a pool of threads
+// input: input data buffer
+// input_size: size of input data
+// output_path: path to write compressed file
+// opts: compression options, or NULL for the defaults
+// Returns: 0 on success, -1 on error
+int compressFileParallel(const unsigned char *input, size_t input_size, const char *output_path,
+                         const CompressOptions *opts);
+
+// Same as compressFileParallel, but reads the input from a descriptor in batches of
+// blocks so that at most opts->memory_budget bytes are held at once
+// in_fd: input descriptor, read from its current offset
+// input_size: bytes to read from in_fd (e.g. from fstat)
+// Returns: 0 on success, -1 on error (including a short input)
+int compressStreamParallel(int in_fd, uint64_t input_size, const char *output_path,
+                           const CompressOptions *opts);
+
+// Decodes every block of a HUF2 container held in memory, fanning blocks out over threads
+// out: buffer of out_size bytes (the original size stored in the header)
+// Returns: 0 on success, -1 on corrupt input
+int decompressBlocks(const unsigned char *in, size_t in_size, unsigned char *out, size_t out_size,
+                     int threads);
+
+// Decodes bytes [offset, offset + length) of a HUF2 container, touching only the blocks
+// that overlap the range
+// dst: buffer of length bytes
+// Returns: 0 on success, -1 on corrupt input or a range outside the original data
+int decompressBlocksRange(const unsigned char *in, size_t in_size, uint64_t offset, size_t length,
+                          unsigned char *dst, int threads);
+
+#endif // PARALLEL_H
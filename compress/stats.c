@@ -0,0 +1,122 @@
+#define _DEFAULT_SOURCE   // clock_gettime con -std=c11
+#include "stats.h"
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+
+static const char *const stage_names[STAT_STAGES] = {
+    "histogram", "code_build", "encode", "decode_table", "decode", "io"
+};
+static const char *const syscall_names[STAT_SYSCALLS] = {
+    "read", "write", "pwritev", "mmap"
+};
+
+#ifdef HUF_STATS
+
+// Los hilos del pool actualizan los mismos contadores: sumas atómicas relajadas,
+// solo importa el total al leerlos.
+typedef struct AtomicStage {
+    _Atomic uint64_t calls;
+    _Atomic uint64_t wall_ns;
+    _Atomic uint64_t cpu_ns;
+    _Atomic uint64_t bytes_in;
+    _Atomic uint64_t bytes_out;
+} AtomicStage;
+
+static AtomicStage stages[STAT_STAGES];
+static _Atomic uint64_t syscalls[STAT_SYSCALLS];
+
+static uint64_t clockNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline void add(_Atomic uint64_t *counter, uint64_t v) {
+    atomic_fetch_add_explicit(counter, v, memory_order_relaxed);
+}
+
+static inline uint64_t load(_Atomic uint64_t *counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+void statsStart(StatTimer *t) {
+    t->wall_ns = clockNs(CLOCK_MONOTONIC);
+    t->cpu_ns = clockNs(CLOCK_THREAD_CPUTIME_ID);
+}
+
+void statsStop(const StatTimer *t, StatStage stage, uint64_t bytes_in, uint64_t bytes_out) {
+    AtomicStage *s = &stages[stage];
+    add(&s->cpu_ns, clockNs(CLOCK_THREAD_CPUTIME_ID) - t->cpu_ns);
+    add(&s->wall_ns, clockNs(CLOCK_MONOTONIC) - t->wall_ns);
+    add(&s->calls, 1);
+    add(&s->bytes_in, bytes_in);
+    add(&s->bytes_out, bytes_out);
+}
+
+void statsSyscall(StatSyscall sys) {
+    add(&syscalls[sys], 1);
+}
+
+int statsEnabled(void) {
+    return 1;
+}
+
+void statsSnapshot(HufStats *out) {
+    for (int i = 0; i < STAT_STAGES; i++) {
+        out->stages[i].calls = load(&stages[i].calls);
+        out->stages[i].wall_ns = load(&stages[i].wall_ns);
+        out->stages[i].cpu_ns = load(&stages[i].cpu_ns);
+        out->stages[i].bytes_in = load(&stages[i].bytes_in);
+        out->stages[i].bytes_out = load(&stages[i].bytes_out);
+    }
+    for (int i = 0; i < STAT_SYSCALLS; i++) { out->syscalls[i] = load(&syscalls[i]); }
+}
+
+void statsReset(void) {
+    for (int i = 0; i < STAT_STAGES; i++) {
+        atomic_store_explicit(&stages[i].calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&stages[i].wall_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&stages[i].cpu_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&stages[i].bytes_in, 0, memory_order_relaxed);
+        atomic_store_explicit(&stages[i].bytes_out, 0, memory_order_relaxed);
+    }
+    for (int i = 0; i < STAT_SYSCALLS; i++) {
+        atomic_store_explicit(&syscalls[i], 0, memory_order_relaxed);
+    }
+}
+
+#else
+
+int statsEnabled(void) {
+    return 0;
+}
+
+void statsSnapshot(HufStats *out) {
+    memset(out, 0, sizeof *out);
+}
+
+void statsReset(void) {
+}
+
+#endif // HUF_STATS
+
+void statsDump(FILE *f) {
+    HufStats st;
+    statsSnapshot(&st);
+
+    fprintf(f, "{\"enabled\": %s, \"stages\": {", statsEnabled() ? "true" : "false");
+    for (int i = 0; i < STAT_STAGES; i++) {
+        const StageStats *s = &st.stages[i];
+        fprintf(f, "%s\"%s\": {\"calls\": %llu, \"wall_ms\": %.3f, \"cpu_ms\": %.3f, "
+                   "\"bytes_in\": %llu, \"bytes_out\": %llu}",
+                i ? ", " : "", stage_names[i], (unsigned long long)s->calls,
+                (double)s->wall_ns / 1e6, (double)s->cpu_ns / 1e6,
+                (unsigned long long)s->bytes_in, (unsigned long long)s->bytes_out);
+    }
+    fprintf(f, "}, \"syscalls\": {");
+    for (int i = 0; i < STAT_SYSCALLS; i++) {
+        fprintf(f, "%s\"%s\": %llu", i ? ", " : "", syscall_names[i], (unsigned long long)st.syscalls[i]);
+    }
+    fprintf(f, "}}\n");
+}
@@ -0,0 +1,82 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Per-stage instrumentation of the compression pipeline, compiled out by default.
+// Building with -DHUF_STATS (make STATS=1) turns the STATS_* hooks below into relaxed
+// atomic updates of process-wide counters; without it they expand to nothing and
+// statsSnapshot() returns zeros. Times are summed over every thread that ran a stage,
+// so with -j they can exceed the elapsed time of the whole run.
+// ENCODE and DECODE time whole HUF1 streams and HUF2 blocks: they include the
+// HISTOGRAM, CODE_BUILD, DECODE_TABLE and IO work done inside them.
+
+typedef enum StatStage {
+    STAT_HISTOGRAM,      // histogramAdd: bytes_in = bytes counted
+    STAT_CODE_BUILD,     // Huffman code construction; calls = encoder tables built
+    STAT_ENCODE,         // HUF1 runs and HUF2 blocks: bytes_in = input, bytes_out = coded
+    STAT_DECODE_TABLE,   // buildDecodeTable; calls = decoder tables built
+    STAT_DECODE,         // HUF1 streams and HUF2 blocks: bytes_in = coded, bytes_out = output
+    STAT_IO,             // read/write/pwritev loops: bytes_in = read, bytes_out = written
+    STAT_STAGES
+} StatStage;
+
+typedef enum StatSyscall {
+    STAT_SYS_READ,
+    STAT_SYS_WRITE,
+    STAT_SYS_PWRITEV,
+    STAT_SYS_MMAP,
+    STAT_SYSCALLS
+} StatSyscall;
+
+typedef struct StageStats {
+    uint64_t calls;
+    uint64_t wall_ns;        // CLOCK_MONOTONIC
+    uint64_t cpu_ns;         // CLOCK_THREAD_CPUTIME_ID of the thread that ran the stage
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+} StageStats;
+
+typedef struct HufStats {
+    StageStats stages[STAT_STAGES];
+    uint64_t syscalls[STAT_SYSCALLS];
+} HufStats;
+
+// Returns: 1 if the library was built with HUF_STATS, 0 if the hooks are compiled out
+int statsEnabled(void);
+
+// Copies the counters accumulated since start-up or the last statsReset()
+void statsSnapshot(HufStats *out);
+
+// Zeroes every counter; not atomic with respect to stages running on other threads
+void statsReset(void);
+
+// Writes the current counters to f as one JSON object
+void statsDump(FILE *f);
+
+#ifdef HUF_STATS
+
+typedef struct StatTimer {
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+} StatTimer;
+
+void statsStart(StatTimer *t);
+void statsStop(const StatTimer *t, StatStage stage, uint64_t bytes_in, uint64_t bytes_out);
+void statsSyscall(StatSyscall sys);
+
+#define STATS_TIMER(t) StatTimer t; statsStart(&t)
+#define STATS_STOP(t, stage, in, out) statsStop(&t, stage, (uint64_t)(in), (uint64_t)(out))
+#define STATS_SYSCALL(sys) statsSyscall(sys)
+
+#else
+
+#define STATS_TIMER(t) ((void)0)
+// sizeof evaluates nothing but counts as a use: no warnings for stats-only variables
+#define STATS_STOP(t, stage, in, out) ((void)sizeof(in), (void)sizeof(out))
+#define STATS_SYSCALL(sys) ((void)0)
+
+#endif // HUF_STATS
+
+#endif // STATS_H
@@ -2,6 +2,7 @@
 #define AES_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "key.h"
 
 typedef enum {
@@ -11,7 +12,16 @@ typedef enum {
 
 typedef uint8_t state_t[4][4];
 
+// Implementation behind key_expansion, aes_encrypt_block(s) and contexts set up afterwards (aes_ctx)
+typedef enum {
+    AES_BACKEND_AUTO = 0,    // AES-NI when the CPU has it, TABLE otherwise
+    AES_BACKEND_TABLE,       // portable T-table rounds; lookups are indexed by secret data
+    AES_BACKEND_AESNI,       // aesni.h
+    AES_BACKEND_BITSLICE,    // constant-time bitsliced rounds and key schedule (bitslice.h)
+} aes_backend_t;
+
 void plaintext_to_state(const uint8_t *plaintext, state_t *state);
+void state_to_output(state_t *state, uint8_t *output);
 void sub_bytes(state_t *state);
 void shift_rows(state_t *state);
 void mix_columns(state_t *state);
@@ -19,4 +29,43 @@ void add_round_key(state_t *state, const word* words, const int round);
 
 aes_code_t encrypt(const uint8_t *plaintext, const uint8_t *key);
 
+// Encrypts one 16-byte block with a schedule from key_expansion, without printing
+void aes_encrypt_block(const uint8_t *plaintext, uint8_t *ciphertext, const word *expanded_key);
+
+// Encrypts blocks consecutive 16-byte blocks independently (ECB); in and out may be the same buffer
+// With AES-NI, AES_INTERLEAVE blocks go through the rounds together to keep the unit busy
+#define AES_INTERLEAVE 8
+void aes_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const word *expanded_key);
+
+// Selects the backend for the whole process; do it before encrypting from several threads
+// Every backend produces the same schedule and ciphertext, so the switch can happen at any time
+// Returns: AES_SUCCESS, or AES_ERROR if this CPU or build lacks it (the selection is unchanged)
+aes_code_t aes_set_backend(aes_backend_t backend);
+
+// Returns: the backend in use, with AES_BACKEND_AUTO resolved
+aes_backend_t aes_get_backend(void);
+
+// Expanded key for many calls: the forward schedule, the equivalent inverse cipher schedule
+// (round keys in reverse order, InvMixColumns applied to rounds 1..Nr-1) and, for the
+// bitsliced backend, both in bit planes. The backend is fixed by aes_ctx_init, so the
+// calls below do no setup and read nothing else: a context is safe to share read-only
+// between threads.
+typedef struct aes_ctx {
+    aes_backend_t backend;
+    word enc_key[4 * (Nr + 1)];
+    word dec_key[4 * (Nr + 1)];
+    uint64_t sliced_enc[16 * (Nr + 1)];   // BITSLICE_KEY_WORDS, only for AES_BACKEND_BITSLICE
+    uint64_t sliced_dec[16 * (Nr + 1)];
+} aes_ctx;
+
+// Expands key with the backend currently selected (aes_get_backend)
+void aes_ctx_init(aes_ctx *ctx, const uint8_t *key);
+
+// Wipes the key material
+void aes_ctx_clear(aes_ctx *ctx);
+
+// Encrypts / decrypts blocks consecutive 16-byte blocks independently (ECB); in and out may be the same buffer
+void aes_ctx_encrypt(const aes_ctx *ctx, const uint8_t *in, uint8_t *out, size_t blocks);
+void aes_ctx_decrypt(const aes_ctx *ctx, const uint8_t *in, uint8_t *out, size_t blocks);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef AESNI_H
+#define AESNI_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "key.h"
+
+// AES-NI backend. key_expansion, aes_encrypt_block(s) and the CTR calls use it when the
+// backend (aes_set_backend) is AES_BACKEND_AESNI, or AES_BACKEND_AUTO and aesni_available().
+// The schedule layout is the same as the portable one, so any backend can use a schedule
+// expanded by another.
+// Build with -DAES_PORTABLE to leave it out.
+
+// Returns: 1 if the CPU reports AES-NI through CPUID and this build includes the backend, 0 otherwise
+int aesni_available(void);
+
+// Same output as the portable key_expansion; only call when aesni_available()
+void aesni_key_expansion(const uint8_t *key, word *words);
+
+// Same output as the portable aes_encrypt_block; only call when aesni_available()
+void aesni_encrypt_block(const uint8_t *plaintext, uint8_t *ciphertext, const word *expanded_key);
+
+// Same output as aes_encrypt_blocks, AES_INTERLEAVE blocks per pass; only call when aesni_available()
+void aesni_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const word *expanded_key);
+
+// Equivalent inverse cipher, AES_INTERLEAVE blocks per pass; decryption_key is the inverse
+// schedule of aes_ctx, the layout aesdec expects. Only call when aesni_available()
+void aesni_decrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const word *decryption_key);
+
+// XORs blocks whole 16-byte blocks of buf with the CTR keystream of counter blocks
+// nonce || BE64(block), nonce || BE64(block + 1), ... (nonce: 8 bytes, see ctr.h)
+// Counters are built in registers; only call when aesni_available()
+void aesni_ctr_xor(const word *expanded_key, const uint8_t *nonce, uint64_t block, uint8_t *buf, size_t blocks);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef BITSLICE_H
+#define BITSLICE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "key.h"
+
+// Bitsliced AES-128 backend: BITSLICE_BLOCKS blocks are transposed into eight SSE2
+// registers, one per bit of every byte, and the S-box is a boolean circuit
+// (Boyar-Peralta: 32 AND and 83 XOR/XNOR), so there are no table lookups and no
+// branches on secret data. Throughput comes from running all blocks in every gate.
+// Build with -DAES_PORTABLE (or without SSE2) to leave it out.
+
+#define BITSLICE_BLOCKS 8
+#define BITSLICE_KEY_WORDS (16 * (Nr + 1))   // uint64_t of a schedule in bit planes
+
+// Returns: 1 if this build includes the backend, 0 otherwise
+int bitslice_available(void);
+
+// Same output as aes_encrypt_blocks; a final group of fewer than BITSLICE_BLOCKS blocks
+// is padded, so it costs a full pass. Only call when bitslice_available()
+void bitslice_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const word *expanded_key);
+
+// Converts Nr + 1 round keys (forward or equivalent inverse schedule) into bit planes;
+// only call when bitslice_available()
+void bitslice_expand_key(uint64_t *sliced_key, const word *round_keys);
+
+// bitslice_encrypt_blocks with a schedule already in bit planes
+void bitslice_encrypt_sliced(const uint64_t *sliced_key, const uint8_t *in, uint8_t *out, size_t blocks);
+
+// Equivalent inverse cipher (FIPS-197 5.3.5) with the inverse schedule of aes_ctx in bit planes
+void bitslice_decrypt_sliced(const uint64_t *sliced_key, const uint8_t *in, uint8_t *out, size_t blocks);
+
+// SubWord of the key schedule through the same circuit; only call when bitslice_available()
+void bitslice_sub_word(uint8_t *w);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef CTR_H
+#define CTR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "aes.h"
+
+// AES-128-CTR. The counter block for byte offset o of a stream is nonce || BE64(o / 16),
+// the layout of openssl's aes-128-ctr with iv = nonce || 0. Encryption and decryption are
+// the same XOR. Counter blocks are independent, so any byte range can be processed on its
+// own: the parallel calls split the buffer into per-thread counter ranges.
+
+#define CTR_NONCE_SIZE 8
+#define CTR_BATCH AES_INTERLEAVE                 // counter blocks encrypted per iteration
+#define CTR_MIN_BYTES_PER_THREAD (256 * 1024)   // smaller ranges are not worth a thread
+#define CTR_FILE_CHUNK (64u << 20)              // bytes read, XORed and written per step
+
+// XORs buf with the keystream starting at byte offset of the stream
+// ctx: from aes_ctx_init; only read, so several threads may use the same one
+void aes_ctr_xor(const aes_ctx *ctx, const uint8_t nonce[CTR_NONCE_SIZE], uint64_t offset,
+                 uint8_t *buf, size_t n);
+
+// Same as aes_ctr_xor with buf split across threads (0 = one per online core) by counter range;
+// a range whose thread cannot be started is done by the calling thread
+void aes_ctr_xor_parallel(const aes_ctx *ctx, const uint8_t nonce[CTR_NONCE_SIZE], uint64_t offset,
+                          uint8_t *buf, size_t n, int threads);
+
+// Encrypts (or decrypts) input_path into output_path, CTR_FILE_CHUNK bytes at a time
+// Returns: AES_SUCCESS, or AES_ERROR on an I/O or thread error
+aes_code_t aes_ctr_file(const char *input_path, const char *output_path, const aes_ctx *ctx,
+                        const uint8_t nonce[CTR_NONCE_SIZE], int threads);
+
+#endif
@@ -2,9 +2,26 @@
     Implementation of the AES-128 cipher algorithm
     By: Sebastián Andrés Uribe Ruiz & Daniel Santana Meza
 */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "include/aes.h"
+#include "include/ctr.h"
 
-int main() {
+// Parses exactly 2 * size hex digits into out
+static int parse_hex(const char *hex, uint8_t *out, size_t size) {
+    if (strlen(hex) != 2 * size) { return -1; }
+    for (size_t i = 0; i < size; i++) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+        if (!isxdigit((unsigned char)byte[0]) || !isxdigit((unsigned char)byte[1])) { return -1; }
+        out[i] = (uint8_t)strtoul(byte, NULL, 16);
+    }
+    return 0;
+}
+
+// FIPS-197 appendix B example
+static int example(void) {
     uint8_t plaintext[16] = {
         0x32, 0x43, 0xf6, 0xa8, 0x88, 0x5a, 0x30, 0x8d, 0x31, 0x31, 0x98, 0xa2, 0xe0, 0x37, 0x07, 0x34
     };
@@ -17,4 +34,71 @@ int main() {
     encrypt(plaintext, key);
 
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char **argv) {
+    // aes128                                        runs the FIPS-197 example block
+    // aes128 -k key -n nonce [-j threads] [-b backend] in out    AES-128-CTR of a whole file; the same command decrypts
+    // key is 32 hex digits, nonce 16 (the counter block is nonce || 64-bit block number, see ctr.h).
+    // -j 0 (the default) uses every online core.
+    // -b auto|table|aesni|bitslice picks the implementation (bitslice: constant time without AES-NI).
+    const char *key_hex = NULL;
+    const char *nonce_hex = NULL;
+    int threads = 0;
+    aes_backend_t backend = AES_BACKEND_AUTO;
+    const char *paths[2] = {NULL, NULL};
+    int npaths = 0;
+
+    if (argc == 1) { return example(); }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            key_hex = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            nonce_hex = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            // An unknown name is an error: falling back to auto could drop a constant-time request
+            const char *name = argv[++i];
+            if (strcmp(name, "auto") == 0) {
+                backend = AES_BACKEND_AUTO;
+            } else if (strcmp(name, "table") == 0) {
+                backend = AES_BACKEND_TABLE;
+            } else if (strcmp(name, "aesni") == 0) {
+                backend = AES_BACKEND_AESNI;
+            } else if (strcmp(name, "bitslice") == 0) {
+                backend = AES_BACKEND_BITSLICE;
+            } else {
+                npaths = -1;
+                break;
+            }
+        } else if (npaths < 2) {
+            paths[npaths++] = argv[i];
+        } else {
+            npaths = -1;
+            break;
+        }
+    }
+
+    uint8_t key[16], nonce[CTR_NONCE_SIZE];
+    if (npaths != 2 || !key_hex || !nonce_hex || parse_hex(key_hex, key, sizeof key) != 0 ||
+        parse_hex(nonce_hex, nonce, sizeof nonce) != 0) {
+        fprintf(stderr, "usage: %s [-k key_hex32 -n nonce_hex16 [-j threads] [-b auto|table|aesni|bitslice] input output]\n", argv[0]);
+        return 1;
+    }
+    if (aes_set_backend(backend) != AES_SUCCESS) {
+        fprintf(stderr, "AES backend not available on this machine.\n");
+        return 1;
+    }
+
+    aes_ctx ctx;
+    aes_ctx_init(&ctx, key);
+    aes_code_t rc = aes_ctr_file(paths[0], paths[1], &ctx, nonce, threads);
+    aes_ctx_clear(&ctx);
+    if (rc != AES_SUCCESS) {
+        fprintf(stderr, "Error encrypting %s.\n", paths[0]);
+        return 1;
+    }
+    return 0;
+}
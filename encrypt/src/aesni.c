@@ -0,0 +1,193 @@
+#include "aesni.h"
+#include "aes.h"
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(AES_PORTABLE)
+#include <wmmintrin.h>
+
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+
+int aesni_available(void) {
+    return __builtin_cpu_supports("aes");
+}
+
+// Next round key from the previous one and aeskeygenassist's RotWord(SubWord(w3)) ^ rcon
+AESNI_TARGET
+static inline __m128i expand_step(__m128i key, __m128i assist) {
+    assist = _mm_shuffle_epi32(assist, 0xff);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+// aeskeygenassist takes the round constant as an immediate, hence the macro
+#define EXPAND_ROUND(i, rcon)                                                   \
+    rk[i] = expand_step(rk[i - 1], _mm_aeskeygenassist_si128(rk[i - 1], rcon)); \
+    _mm_storeu_si128((__m128i *)words[4 * (i)], rk[i])
+
+AESNI_TARGET
+void aesni_key_expansion(const uint8_t *key, word *words) {
+    __m128i rk[Nr + 1];
+    rk[0] = _mm_loadu_si128((const __m128i *)key);
+    _mm_storeu_si128((__m128i *)words[0], rk[0]);
+    EXPAND_ROUND(1, 0x01);
+    EXPAND_ROUND(2, 0x02);
+    EXPAND_ROUND(3, 0x04);
+    EXPAND_ROUND(4, 0x08);
+    EXPAND_ROUND(5, 0x10);
+    EXPAND_ROUND(6, 0x20);
+    EXPAND_ROUND(7, 0x40);
+    EXPAND_ROUND(8, 0x80);
+    EXPAND_ROUND(9, 0x1B);
+    EXPAND_ROUND(10, 0x36);
+}
+
+AESNI_TARGET
+void aesni_encrypt_block(const uint8_t *plaintext, uint8_t *ciphertext, const word *expanded_key) {
+    const __m128i *rk = (const __m128i *)expanded_key;
+    __m128i s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)plaintext), _mm_loadu_si128(rk));
+    for (int round = 1; round < Nr; round++) {
+        s = _mm_aesenc_si128(s, _mm_loadu_si128(rk + round));
+    }
+    s = _mm_aesenclast_si128(s, _mm_loadu_si128(rk + Nr));
+    _mm_storeu_si128((__m128i *)ciphertext, s);
+}
+
+// aesenc has a latency of several cycles but accepts a new one every cycle: rounds of
+// AES_INTERLEAVE independent blocks are issued back to back to hide it
+AESNI_TARGET
+void aesni_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const word *expanded_key) {
+    __m128i rk[Nr + 1];
+    for (int round = 0; round <= Nr; round++) {
+        rk[round] = _mm_loadu_si128((const __m128i *)expanded_key + round);
+    }
+
+    size_t i = 0;
+    for (; i + AES_INTERLEAVE <= blocks; i += AES_INTERLEAVE) {
+        const __m128i *src = (const __m128i *)(in + 16 * i);
+        __m128i s[AES_INTERLEAVE];
+#pragma GCC unroll 8
+        for (int b = 0; b < AES_INTERLEAVE; b++) { s[b] = _mm_xor_si128(_mm_loadu_si128(src + b), rk[0]); }
+        for (int round = 1; round < Nr; round++) {
+#pragma GCC unroll 8
+            for (int b = 0; b < AES_INTERLEAVE; b++) { s[b] = _mm_aesenc_si128(s[b], rk[round]); }
+        }
+        __m128i *dst = (__m128i *)(out + 16 * i);
+#pragma GCC unroll 8
+        for (int b = 0; b < AES_INTERLEAVE; b++) { _mm_storeu_si128(dst + b, _mm_aesenclast_si128(s[b], rk[Nr])); }
+    }
+    for (; i < blocks; i++) {
+        __m128i s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + 16 * i)), rk[0]);
+        for (int round = 1; round < Nr; round++) { s = _mm_aesenc_si128(s, rk[round]); }
+        _mm_storeu_si128((__m128i *)(out + 16 * i), _mm_aesenclast_si128(s, rk[Nr]));
+    }
+}
+
+AESNI_TARGET
+void aesni_decrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const word *decryption_key) {
+    __m128i rk[Nr + 1];
+    for (int round = 0; round <= Nr; round++) {
+        rk[round] = _mm_loadu_si128((const __m128i *)decryption_key + round);
+    }
+
+    size_t i = 0;
+    for (; i + AES_INTERLEAVE <= blocks; i += AES_INTERLEAVE) {
+        const __m128i *src = (const __m128i *)(in + 16 * i);
+        __m128i s[AES_INTERLEAVE];
+#pragma GCC unroll 8
+        for (int b = 0; b < AES_INTERLEAVE; b++) { s[b] = _mm_xor_si128(_mm_loadu_si128(src + b), rk[0]); }
+        for (int round = 1; round < Nr; round++) {
+#pragma GCC unroll 8
+            for (int b = 0; b < AES_INTERLEAVE; b++) { s[b] = _mm_aesdec_si128(s[b], rk[round]); }
+        }
+        __m128i *dst = (__m128i *)(out + 16 * i);
+#pragma GCC unroll 8
+        for (int b = 0; b < AES_INTERLEAVE; b++) { _mm_storeu_si128(dst + b, _mm_aesdeclast_si128(s[b], rk[Nr])); }
+    }
+    for (; i < blocks; i++) {
+        __m128i s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + 16 * i)), rk[0]);
+        for (int round = 1; round < Nr; round++) { s = _mm_aesdec_si128(s, rk[round]); }
+        _mm_storeu_si128((__m128i *)(out + 16 * i), _mm_aesdeclast_si128(s, rk[Nr]));
+    }
+}
+
+// Counter block: the nonce in the low lane, the big-endian block number in the high one
+AESNI_TARGET
+static inline __m128i counter_block(uint64_t nonce, uint64_t block) {
+    return _mm_set_epi64x((long long)__builtin_bswap64(block), (long long)nonce);
+}
+
+AESNI_TARGET
+void aesni_ctr_xor(const word *expanded_key, const uint8_t *nonce, uint64_t block, uint8_t *buf, size_t blocks) {
+    __m128i rk[Nr + 1];
+    for (int round = 0; round <= Nr; round++) {
+        rk[round] = _mm_loadu_si128((const __m128i *)expanded_key + round);
+    }
+    uint64_t n;
+    memcpy(&n, nonce, sizeof n);
+
+    size_t i = 0;
+    for (; i + AES_INTERLEAVE <= blocks; i += AES_INTERLEAVE, block += AES_INTERLEAVE) {
+        __m128i s[AES_INTERLEAVE];
+#pragma GCC unroll 8
+        for (int b = 0; b < AES_INTERLEAVE; b++) { s[b] = _mm_xor_si128(counter_block(n, block + b), rk[0]); }
+        for (int round = 1; round < Nr; round++) {
+#pragma GCC unroll 8
+            for (int b = 0; b < AES_INTERLEAVE; b++) { s[b] = _mm_aesenc_si128(s[b], rk[round]); }
+        }
+        __m128i *p = (__m128i *)(buf + 16 * i);
+#pragma GCC unroll 8
+        for (int b = 0; b < AES_INTERLEAVE; b++) {
+            __m128i ks = _mm_aesenclast_si128(s[b], rk[Nr]);
+            _mm_storeu_si128(p + b, _mm_xor_si128(_mm_loadu_si128(p + b), ks));
+        }
+    }
+    for (; i < blocks; i++, block++) {
+        __m128i s = _mm_xor_si128(counter_block(n, block), rk[0]);
+        for (int round = 1; round < Nr; round++) { s = _mm_aesenc_si128(s, rk[round]); }
+        __m128i *p = (__m128i *)(buf + 16 * i);
+        _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), _mm_aesenclast_si128(s, rk[Nr])));
+    }
+}
+
+#else
+
+int aesni_available(void) {
+    return 0;
+}
+
+void aesni_key_expansion(const uint8_t *key, word *words) {
+    (void)key;
+    (void)words;
+}
+
+void aesni_encrypt_block(const uint8_t *plaintext, uint8_t *ciphertext, const word *expanded_key) {
+    (void)plaintext;
+    (void)ciphertext;
+    (void)expanded_key;
+}
+
+void aesni_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const word *expanded_key) {
+    (void)in;
+    (void)out;
+    (void)blocks;
+    (void)expanded_key;
+}
+
+void aesni_decrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const word *decryption_key) {
+    (void)in;
+    (void)out;
+    (void)blocks;
+    (void)decryption_key;
+}
+
+void aesni_ctr_xor(const word *expanded_key, const uint8_t *nonce, uint64_t block, uint8_t *buf, size_t blocks) {
+    (void)expanded_key;
+    (void)nonce;
+    (void)block;
+    (void)buf;
+    (void)blocks;
+}
+
+#endif
@@ -0,0 +1,477 @@
+#include <string.h>
+#include "bitslice.h"
+
+#if defined(__SSE2__) && !defined(AES_PORTABLE)
+#include <emmintrin.h>
+
+// Layout: each 64-bit lane holds one bit plane of four blocks (64 bytes), arranged so that
+// ShiftRows and MixColumns become shifts and rotations inside the lane. The low lane carries
+// blocks 0-3 and the high lane blocks 4-7; q[i] is bit i of every byte.
+
+#define XOR(a, b) _mm_xor_si128(a, b)
+#define AND(a, b) _mm_and_si128(a, b)
+#define OR(a, b) _mm_or_si128(a, b)
+#define NOT(a) _mm_xor_si128(a, _mm_set1_epi32(-1))
+#define MASK(m) _mm_set1_epi64x((long long)(m))
+
+int bitslice_available(void) {
+    return 1;
+}
+
+static inline uint32_t load_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Spreads the four columns of one block over the even and odd bytes of two lanes
+static void interleave_in(uint64_t *q0, uint64_t *q1, const uint8_t *block) {
+    uint64_t x[4];
+    for (int k = 0; k < 4; k++) {
+        x[k] = load_le32(block + 4 * k);
+        x[k] |= x[k] << 16;
+        x[k] &= 0x0000FFFF0000FFFFull;
+        x[k] |= x[k] << 8;
+        x[k] &= 0x00FF00FF00FF00FFull;
+    }
+    *q0 = x[0] | (x[2] << 8);
+    *q1 = x[1] | (x[3] << 8);
+}
+
+static void interleave_out(uint8_t *block, uint64_t q0, uint64_t q1) {
+    uint64_t x[4];
+    x[0] = q0 & 0x00FF00FF00FF00FFull;
+    x[1] = q1 & 0x00FF00FF00FF00FFull;
+    x[2] = (q0 >> 8) & 0x00FF00FF00FF00FFull;
+    x[3] = (q1 >> 8) & 0x00FF00FF00FF00FFull;
+    for (int k = 0; k < 4; k++) {
+        x[k] |= x[k] >> 8;
+        x[k] &= 0x0000FFFF0000FFFFull;
+        store_le32(block + 4 * k, (uint32_t)x[k] | (uint32_t)(x[k] >> 16));
+    }
+}
+
+// Swaps the bits selected by cl in y with those selected by ch in x, s positions apart
+#define SWAPN(cl, ch, s, x, y)                                                          \
+    do {                                                                                \
+        __m128i a = (x), b = (y);                                                       \
+        (x) = OR(AND(a, MASK(cl)), _mm_slli_epi64(AND(b, MASK(cl)), s));                \
+        (y) = OR(_mm_srli_epi64(AND(a, MASK(ch)), s), AND(b, MASK(ch)));                \
+    } while (0)
+
+// Transposes 8x8 bit blocks: bytes become bit planes and back (it is its own inverse)
+static void ortho(__m128i *q) {
+    SWAPN(0x5555555555555555ull, 0xAAAAAAAAAAAAAAAAull, 1, q[0], q[1]);
+    SWAPN(0x5555555555555555ull, 0xAAAAAAAAAAAAAAAAull, 1, q[2], q[3]);
+    SWAPN(0x5555555555555555ull, 0xAAAAAAAAAAAAAAAAull, 1, q[4], q[5]);
+    SWAPN(0x5555555555555555ull, 0xAAAAAAAAAAAAAAAAull, 1, q[6], q[7]);
+
+    SWAPN(0x3333333333333333ull, 0xCCCCCCCCCCCCCCCCull, 2, q[0], q[2]);
+    SWAPN(0x3333333333333333ull, 0xCCCCCCCCCCCCCCCCull, 2, q[1], q[3]);
+    SWAPN(0x3333333333333333ull, 0xCCCCCCCCCCCCCCCCull, 2, q[4], q[6]);
+    SWAPN(0x3333333333333333ull, 0xCCCCCCCCCCCCCCCCull, 2, q[5], q[7]);
+
+    SWAPN(0x0F0F0F0F0F0F0F0Full, 0xF0F0F0F0F0F0F0F0ull, 4, q[0], q[4]);
+    SWAPN(0x0F0F0F0F0F0F0F0Full, 0xF0F0F0F0F0F0F0F0ull, 4, q[1], q[5]);
+    SWAPN(0x0F0F0F0F0F0F0F0Full, 0xF0F0F0F0F0F0F0F0ull, 4, q[2], q[6]);
+    SWAPN(0x0F0F0F0F0F0F0F0Full, 0xF0F0F0F0F0F0F0F0ull, 4, q[3], q[7]);
+}
+
+// Loads BITSLICE_BLOCKS blocks into bit planes
+static void load_blocks(__m128i *q, const uint8_t *in) {
+    uint64_t lo[8], hi[8];
+    for (int i = 0; i < 4; i++) {
+        interleave_in(&lo[i], &lo[i + 4], in + 16 * i);
+        interleave_in(&hi[i], &hi[i + 4], in + 16 * (i + 4));
+    }
+    for (int i = 0; i < 8; i++) {
+        q[i] = _mm_set_epi64x((long long)hi[i], (long long)lo[i]);
+    }
+    ortho(q);
+}
+
+static void store_blocks(uint8_t *out, __m128i *q) {
+    uint64_t lanes[8][2];
+    ortho(q);
+    for (int i = 0; i < 8; i++) {
+        _mm_storeu_si128((__m128i *)lanes[i], q[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        interleave_out(out + 16 * i, lanes[i][0], lanes[i + 4][0]);
+        interleave_out(out + 16 * (i + 4), lanes[i][1], lanes[i + 4][1]);
+    }
+}
+
+// S-box on every byte at once: GF(2^8) inversion through the tower-field circuit of
+// Boyar and Peralta, followed by the affine map (the XNORs are its constant 0x63)
+static void sbox(__m128i *q) {
+    __m128i x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4];
+    __m128i x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+    // Top linear transformation
+    __m128i y14 = XOR(x3, x5);
+    __m128i y13 = XOR(x0, x6);
+    __m128i y9 = XOR(x0, x3);
+    __m128i y8 = XOR(x0, x5);
+    __m128i t0 = XOR(x1, x2);
+    __m128i y1 = XOR(t0, x7);
+    __m128i y4 = XOR(y1, x3);
+    __m128i y12 = XOR(y13, y14);
+    __m128i y2 = XOR(y1, x0);
+    __m128i y5 = XOR(y1, x6);
+    __m128i y3 = XOR(y5, y8);
+    __m128i t1 = XOR(x4, y12);
+    __m128i y15 = XOR(t1, x5);
+    __m128i y20 = XOR(t1, x1);
+    __m128i y6 = XOR(y15, x7);
+    __m128i y10 = XOR(y15, t0);
+    __m128i y11 = XOR(y20, y9);
+    __m128i y7 = XOR(x7, y11);
+    __m128i y17 = XOR(y10, y11);
+    __m128i y19 = XOR(y10, y8);
+    __m128i y16 = XOR(t0, y11);
+    __m128i y21 = XOR(y13, y16);
+    __m128i y18 = XOR(x0, y16);
+
+    // Non-linear section
+    __m128i t2 = AND(y12, y15);
+    __m128i t3 = AND(y3, y6);
+    __m128i t4 = XOR(t3, t2);
+    __m128i t5 = AND(y4, x7);
+    __m128i t6 = XOR(t5, t2);
+    __m128i t7 = AND(y13, y16);
+    __m128i t8 = AND(y5, y1);
+    __m128i t9 = XOR(t8, t7);
+    __m128i t10 = AND(y2, y7);
+    __m128i t11 = XOR(t10, t7);
+    __m128i t12 = AND(y9, y11);
+    __m128i t13 = AND(y14, y17);
+    __m128i t14 = XOR(t13, t12);
+    __m128i t15 = AND(y8, y10);
+    __m128i t16 = XOR(t15, t12);
+    __m128i t17 = XOR(t4, t14);
+    __m128i t18 = XOR(t6, t16);
+    __m128i t19 = XOR(t9, t14);
+    __m128i t20 = XOR(t11, t16);
+    __m128i t21 = XOR(t17, y20);
+    __m128i t22 = XOR(t18, y19);
+    __m128i t23 = XOR(t19, y21);
+    __m128i t24 = XOR(t20, y18);
+
+    __m128i t25 = XOR(t21, t22);
+    __m128i t26 = AND(t21, t23);
+    __m128i t27 = XOR(t24, t26);
+    __m128i t28 = AND(t25, t27);
+    __m128i t29 = XOR(t28, t22);
+    __m128i t30 = XOR(t23, t24);
+    __m128i t31 = XOR(t22, t26);
+    __m128i t32 = AND(t31, t30);
+    __m128i t33 = XOR(t32, t24);
+    __m128i t34 = XOR(t23, t33);
+    __m128i t35 = XOR(t27, t33);
+    __m128i t36 = AND(t24, t35);
+    __m128i t37 = XOR(t36, t34);
+    __m128i t38 = XOR(t27, t36);
+    __m128i t39 = AND(t29, t38);
+    __m128i t40 = XOR(t25, t39);
+
+    __m128i t41 = XOR(t40, t37);
+    __m128i t42 = XOR(t29, t33);
+    __m128i t43 = XOR(t29, t40);
+    __m128i t44 = XOR(t33, t37);
+    __m128i t45 = XOR(t42, t41);
+    __m128i z0 = AND(t44, y15);
+    __m128i z1 = AND(t37, y6);
+    __m128i z2 = AND(t33, x7);
+    __m128i z3 = AND(t43, y16);
+    __m128i z4 = AND(t40, y1);
+    __m128i z5 = AND(t29, y7);
+    __m128i z6 = AND(t42, y11);
+    __m128i z7 = AND(t45, y17);
+    __m128i z8 = AND(t41, y10);
+    __m128i z9 = AND(t44, y12);
+    __m128i z10 = AND(t37, y3);
+    __m128i z11 = AND(t33, y4);
+    __m128i z12 = AND(t43, y13);
+    __m128i z13 = AND(t40, y5);
+    __m128i z14 = AND(t29, y2);
+    __m128i z15 = AND(t42, y9);
+    __m128i z16 = AND(t45, y14);
+    __m128i z17 = AND(t41, y8);
+
+    // Bottom linear transformation
+    __m128i t46 = XOR(z15, z16);
+    __m128i t47 = XOR(z10, z11);
+    __m128i t48 = XOR(z5, z13);
+    __m128i t49 = XOR(z9, z10);
+    __m128i t50 = XOR(z2, z12);
+    __m128i t51 = XOR(z2, z5);
+    __m128i t52 = XOR(z7, z8);
+    __m128i t53 = XOR(z0, z3);
+    __m128i t54 = XOR(z6, z7);
+    __m128i t55 = XOR(z16, z17);
+    __m128i t56 = XOR(z12, t48);
+    __m128i t57 = XOR(t50, t53);
+    __m128i t58 = XOR(z4, t46);
+    __m128i t59 = XOR(z3, t54);
+    __m128i t60 = XOR(t46, t57);
+    __m128i t61 = XOR(z14, t57);
+    __m128i t62 = XOR(t52, t58);
+    __m128i t63 = XOR(t49, t58);
+    __m128i t64 = XOR(z4, t59);
+    __m128i t65 = XOR(t61, t62);
+    __m128i t66 = XOR(z1, t63);
+    __m128i s0 = XOR(t59, t63);
+    __m128i s6 = XOR(t56, NOT(t62));
+    __m128i s7 = XOR(t48, NOT(t60));
+    __m128i t67 = XOR(t64, t65);
+    __m128i s3 = XOR(t53, t66);
+    __m128i s4 = XOR(t51, t66);
+    __m128i s5 = XOR(t47, t65);
+    __m128i s1 = XOR(t64, NOT(s3));
+    __m128i s2 = XOR(t55, NOT(t67));
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+// Rows are 16-bit groups of a lane: row r rotates by r nibble-pairs within its group
+static void shift_rows(__m128i *q) {
+    for (int i = 0; i < 8; i++) {
+        __m128i x = q[i];
+        q[i] = OR(OR(OR(AND(x, MASK(0x000000000000FFFFull)),
+                        _mm_srli_epi64(AND(x, MASK(0x00000000FFF00000ull)), 4)),
+                     OR(_mm_slli_epi64(AND(x, MASK(0x00000000000F0000ull)), 12),
+                        _mm_srli_epi64(AND(x, MASK(0x0000FF0000000000ull)), 8))),
+                  OR(OR(_mm_slli_epi64(AND(x, MASK(0x000000FF00000000ull)), 8),
+                        _mm_srli_epi64(AND(x, MASK(0xF000000000000000ull)), 12)),
+                     _mm_slli_epi64(AND(x, MASK(0x0FFF000000000000ull)), 4)));
+    }
+}
+
+// Rotations of a 64-bit lane by 16 and 32 bits (one row and two rows of a column)
+static inline __m128i rotr16(__m128i x) {
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(0, 3, 2, 1)), _MM_SHUFFLE(0, 3, 2, 1));
+}
+
+static inline __m128i rotr32(__m128i x) {
+    return _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+// Multiplication by x is a shift of the bit planes with the reduction folded into
+// planes 0, 1, 3 and 4 (0x1B)
+static void mix_columns(__m128i *q) {
+    __m128i r[8];
+    for (int i = 0; i < 8; i++) { r[i] = rotr16(q[i]); }
+    __m128i q7r7 = XOR(q[7], r[7]);
+
+    __m128i n0 = XOR(XOR(q7r7, r[0]), rotr32(XOR(q[0], r[0])));
+    __m128i n1 = XOR(XOR(XOR(q[0], r[0]), q7r7), XOR(r[1], rotr32(XOR(q[1], r[1]))));
+    __m128i n2 = XOR(XOR(q[1], r[1]), XOR(r[2], rotr32(XOR(q[2], r[2]))));
+    __m128i n3 = XOR(XOR(XOR(q[2], r[2]), q7r7), XOR(r[3], rotr32(XOR(q[3], r[3]))));
+    __m128i n4 = XOR(XOR(XOR(q[3], r[3]), q7r7), XOR(r[4], rotr32(XOR(q[4], r[4]))));
+    __m128i n5 = XOR(XOR(q[4], r[4]), XOR(r[5], rotr32(XOR(q[5], r[5]))));
+    __m128i n6 = XOR(XOR(q[5], r[5]), XOR(r[6], rotr32(XOR(q[6], r[6]))));
+    __m128i n7 = XOR(XOR(q[6], r[6]), XOR(r[7], rotr32(XOR(q[7], r[7]))));
+    q[0] = n0;
+    q[1] = n1;
+    q[2] = n2;
+    q[3] = n3;
+    q[4] = n4;
+    q[5] = n5;
+    q[6] = n6;
+    q[7] = n7;
+}
+
+// Inverse S-box from the forward circuit. With L(y) = A^-1(y ^ 0x63), the inverse of the
+// affine map: the field inverse is L(S(x)), so InvS(y) = L(S(L(y))).
+static void inv_affine(__m128i *q) {
+    __m128i x[8];
+    for (int i = 0; i < 8; i++) {
+        x[i] = XOR(XOR(q[(i + 2) % 8], q[(i + 5) % 8]), q[(i + 7) % 8]);
+    }
+    for (int i = 0; i < 8; i++) { q[i] = x[i]; }
+    q[0] = NOT(q[0]);   // 0x05
+    q[2] = NOT(q[2]);
+}
+
+static void inv_sbox(__m128i *q) {
+    inv_affine(q);
+    sbox(q);
+    inv_affine(q);
+}
+
+static void inv_shift_rows(__m128i *q) {
+    for (int i = 0; i < 8; i++) {
+        __m128i x = q[i];
+        q[i] = OR(OR(OR(AND(x, MASK(0x000000000000FFFFull)),
+                        _mm_slli_epi64(AND(x, MASK(0x000000000FFF0000ull)), 4)),
+                     OR(_mm_srli_epi64(AND(x, MASK(0x00000000F0000000ull)), 12),
+                        _mm_slli_epi64(AND(x, MASK(0x000000FF00000000ull)), 8))),
+                  OR(OR(_mm_srli_epi64(AND(x, MASK(0x0000FF0000000000ull)), 8),
+                        _mm_slli_epi64(AND(x, MASK(0x000F000000000000ull)), 12)),
+                     _mm_srli_epi64(AND(x, MASK(0xFFF0000000000000ull)), 4)));
+    }
+}
+
+// Multiplication of every byte by x
+static void xtime(__m128i *q) {
+    __m128i q7 = q[7];
+    q[7] = q[6];
+    q[6] = q[5];
+    q[5] = q[4];
+    q[4] = XOR(q[3], q7);
+    q[3] = XOR(q[2], q7);
+    q[2] = q[1];
+    q[1] = XOR(q[0], q7);
+    q[0] = q7;
+}
+
+// InvMixColumns = MixColumns after multiplying each column by 05 + 04 x^2,
+// i.e. a ^= 04 * (a ^ (a rotated by two rows))
+static void inv_mix_columns(__m128i *q) {
+    __m128i t[8];
+    for (int i = 0; i < 8; i++) { t[i] = XOR(q[i], rotr32(q[i])); }
+    xtime(t);
+    xtime(t);
+    for (int i = 0; i < 8; i++) { q[i] = XOR(q[i], t[i]); }
+    mix_columns(q);
+}
+
+static inline void add_round_key(__m128i *q, const uint64_t *sk) {
+    for (int i = 0; i < 8; i++) { q[i] = XOR(q[i], _mm_loadu_si128((const __m128i *)(sk + 2 * i))); }
+}
+
+// Each round key is loaded as BITSLICE_BLOCKS copies, so it lines up with every block
+void bitslice_expand_key(uint64_t *sliced_key, const word *round_keys) {
+    uint8_t copies[16 * BITSLICE_BLOCKS];
+    __m128i q[8];
+    for (int round = 0; round <= Nr; round++) {
+        for (int b = 0; b < BITSLICE_BLOCKS; b++) {
+            memcpy(copies + 16 * b, round_keys[4 * round], 16);
+        }
+        load_blocks(q, copies);
+        for (int i = 0; i < 8; i++) {
+            _mm_storeu_si128((__m128i *)(sliced_key + 16 * round + 2 * i), q[i]);
+        }
+    }
+}
+
+static void encrypt_planes(__m128i *q, const uint64_t *sk) {
+    add_round_key(q, sk);
+    for (int round = 1; round < Nr; round++) {
+        sbox(q);
+        shift_rows(q);
+        mix_columns(q);
+        add_round_key(q, sk + 16 * round);
+    }
+    sbox(q);
+    shift_rows(q);
+    add_round_key(q, sk + 16 * Nr);
+}
+
+static void decrypt_planes(__m128i *q, const uint64_t *sk) {
+    add_round_key(q, sk);
+    for (int round = 1; round < Nr; round++) {
+        inv_sbox(q);
+        inv_shift_rows(q);
+        inv_mix_columns(q);
+        add_round_key(q, sk + 16 * round);
+    }
+    inv_sbox(q);
+    inv_shift_rows(q);
+    add_round_key(q, sk + 16 * Nr);
+}
+
+// Runs fn over groups of BITSLICE_BLOCKS blocks, padding the last one
+static void for_each_group(void (*fn)(__m128i *, const uint64_t *), const uint64_t *sk,
+                           const uint8_t *in, uint8_t *out, size_t blocks) {
+    __m128i q[8];
+    size_t i = 0;
+    for (; i + BITSLICE_BLOCKS <= blocks; i += BITSLICE_BLOCKS) {
+        load_blocks(q, in + 16 * i);
+        fn(q, sk);
+        store_blocks(out + 16 * i, q);
+    }
+    if (i < blocks) {
+        uint8_t tail[16 * BITSLICE_BLOCKS] = {0};
+        memcpy(tail, in + 16 * i, 16 * (blocks - i));
+        load_blocks(q, tail);
+        fn(q, sk);
+        store_blocks(tail, q);
+        memcpy(out + 16 * i, tail, 16 * (blocks - i));
+    }
+}
+
+void bitslice_encrypt_sliced(const uint64_t *sliced_key, const uint8_t *in, uint8_t *out, size_t blocks) {
+    for_each_group(encrypt_planes, sliced_key, in, out, blocks);
+}
+
+void bitslice_decrypt_sliced(const uint64_t *sliced_key, const uint8_t *in, uint8_t *out, size_t blocks) {
+    for_each_group(decrypt_planes, sliced_key, in, out, blocks);
+}
+
+void bitslice_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const word *expanded_key) {
+    uint64_t sliced_key[BITSLICE_KEY_WORDS];
+    bitslice_expand_key(sliced_key, expanded_key);
+    bitslice_encrypt_sliced(sliced_key, in, out, blocks);
+}
+
+void bitslice_sub_word(uint8_t *w) {
+    uint8_t block[16 * BITSLICE_BLOCKS] = {0};
+    memcpy(block, w, 4);
+    __m128i q[8];
+    load_blocks(q, block);
+    sbox(q);
+    store_blocks(block, q);
+    memcpy(w, block, 4);
+}
+
+#else
+
+int bitslice_available(void) {
+    return 0;
+}
+
+void bitslice_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const word *expanded_key) {
+    (void)in;
+    (void)out;
+    (void)blocks;
+    (void)expanded_key;
+}
+
+void bitslice_expand_key(uint64_t *sliced_key, const word *round_keys) {
+    (void)sliced_key;
+    (void)round_keys;
+}
+
+void bitslice_encrypt_sliced(const uint64_t *sliced_key, const uint8_t *in, uint8_t *out, size_t blocks) {
+    (void)sliced_key;
+    (void)in;
+    (void)out;
+    (void)blocks;
+}
+
+void bitslice_decrypt_sliced(const uint64_t *sliced_key, const uint8_t *in, uint8_t *out, size_t blocks) {
+    (void)sliced_key;
+    (void)in;
+    (void)out;
+    (void)blocks;
+}
+
+void bitslice_sub_word(uint8_t *w) {
+    (void)w;
+}
+
+#endif
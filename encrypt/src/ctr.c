@@ -0,0 +1,177 @@
+#define _POSIX_C_SOURCE 200809L   // sysconf with -std=c11
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ctr.h"
+#include "aesni.h"
+
+#define CTR_MAX_THREADS 64
+
+static inline void store_be64(uint8_t *p, uint64_t v) {
+    for (int b = 0; b < 8; b++) {
+        p[7 - b] = (uint8_t)(v >> (8 * b));
+    }
+}
+
+// XOR eight bytes at a time; memcpy keeps unaligned buffers legal
+static void xor_bytes(uint8_t *dst, const uint8_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t a, b;
+        memcpy(&a, dst + i, 8);
+        memcpy(&b, src + i, 8);
+        a ^= b;
+        memcpy(dst + i, &a, 8);
+    }
+    for (; i < n; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+// Table and bitsliced backends: CTR_BATCH counter blocks through aes_ctx_encrypt,
+// then one XOR pass
+static void ctr_xor_batches(const aes_ctx *ctx, const uint8_t nonce[CTR_NONCE_SIZE], uint64_t offset,
+                            uint8_t *buf, size_t n) {
+    uint8_t counters[16 * CTR_BATCH], keystream[16 * CTR_BATCH];
+    for (int b = 0; b < CTR_BATCH; b++) {
+        memcpy(counters + 16 * b, nonce, CTR_NONCE_SIZE);
+    }
+
+    uint64_t block = offset / 16;
+    size_t skip = (size_t)(offset % 16);   // only the first block can start mid-way
+    size_t i = 0;
+    while (i < n) {
+        size_t want = (skip + (n - i) + 15) / 16;
+        size_t count = want < CTR_BATCH ? want : CTR_BATCH;
+        for (size_t b = 0; b < count; b++) {
+            store_be64(counters + 16 * b + CTR_NONCE_SIZE, block + b);
+        }
+        aes_ctx_encrypt(ctx, counters, keystream, count);
+
+        size_t take = 16 * count - skip;
+        if (take > n - i) { take = n - i; }
+        xor_bytes(buf + i, keystream + skip, take);
+        i += take;
+        block += count;
+        skip = 0;
+    }
+}
+
+void aes_ctr_xor(const aes_ctx *ctx, const uint8_t nonce[CTR_NONCE_SIZE], uint64_t offset,
+                 uint8_t *buf, size_t n) {
+    if (ctx->backend != AES_BACKEND_AESNI) {
+        ctr_xor_batches(ctx, nonce, offset, buf, n);
+        return;
+    }
+
+    // AES-NI keeps the counters in registers; only a partial first or last block goes the slow way
+    size_t head = (16 - (size_t)(offset % 16)) % 16;
+    if (head > n) { head = n; }
+    ctr_xor_batches(ctx, nonce, offset, buf, head);
+    size_t blocks = (n - head) / 16;
+    aesni_ctr_xor((const word *)ctx->enc_key, nonce, (offset + head) / 16, buf + head, blocks);
+    size_t done = head + 16 * blocks;
+    ctr_xor_batches(ctx, nonce, offset + done, buf + done, n - done);
+}
+
+typedef struct ctr_range {
+    const aes_ctx *ctx;
+    const uint8_t *nonce;
+    uint64_t offset;
+    uint8_t *buf;
+    size_t n;
+} ctr_range;
+
+static void *ctr_worker(void *arg) {
+    ctr_range *r = arg;
+    aes_ctr_xor(r->ctx, r->nonce, r->offset, r->buf, r->n);
+    return NULL;
+}
+
+void aes_ctr_xor_parallel(const aes_ctx *ctx, const uint8_t nonce[CTR_NONCE_SIZE], uint64_t offset,
+                          uint8_t *buf, size_t n, int threads) {
+    if (threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 0 ? (int)cores : 1;
+    }
+    if (threads > CTR_MAX_THREADS) { threads = CTR_MAX_THREADS; }
+    if ((size_t)threads > n / CTR_MIN_BYTES_PER_THREAD) {
+        threads = (int)(n / CTR_MIN_BYTES_PER_THREAD);
+    }
+    if (threads <= 1) {
+        aes_ctr_xor(ctx, nonce, offset, buf, n);
+        return;
+    }
+
+    // Ranges are whole batches of counter blocks so that no two threads share one
+    size_t per = (n / (size_t)threads + 16 * CTR_BATCH - 1) / (16 * CTR_BATCH) * (16 * CTR_BATCH);
+    ctr_range ranges[CTR_MAX_THREADS];
+    pthread_t tids[CTR_MAX_THREADS];
+    int started[CTR_MAX_THREADS];
+    int count = 0;
+    for (size_t start = 0; start < n; start += per, count++) {
+        ranges[count] = (ctr_range){ctx, nonce, offset + start, buf + start,
+                                    n - start < per ? n - start : per};
+        // The last range runs on the calling thread, as does any that cannot get its own
+        started[count] = start + per < n && pthread_create(&tids[count], NULL, ctr_worker, &ranges[count]) == 0;
+        if (!started[count]) { ctr_worker(&ranges[count]); }
+    }
+    for (int t = 0; t < count; t++) {
+        if (started[t]) { pthread_join(tids[t], NULL); }
+    }
+}
+
+static int read_full(int fd, uint8_t *buf, size_t size, size_t *got) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, buf + done, size - done);
+        if (n < 0) { return -1; }
+        if (n == 0) { break; }
+        done += (size_t)n;
+    }
+    *got = done;
+    return 0;
+}
+
+static int write_full(int fd, const uint8_t *buf, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = write(fd, buf + done, size - done);
+        if (n <= 0) { return -1; }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+aes_code_t aes_ctr_file(const char *input_path, const char *output_path, const aes_ctx *ctx,
+                        const uint8_t nonce[CTR_NONCE_SIZE], int threads) {
+    int in = open(input_path, O_RDONLY);
+    if (in < 0) { return AES_ERROR; }
+    int out = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        close(in);
+        return AES_ERROR;
+    }
+
+    uint8_t *chunk = malloc(CTR_FILE_CHUNK);
+    aes_code_t rc = chunk ? AES_SUCCESS : AES_ERROR;
+    uint64_t offset = 0;
+    while (rc == AES_SUCCESS) {
+        size_t n;
+        if (read_full(in, chunk, CTR_FILE_CHUNK, &n) != 0) {
+            rc = AES_ERROR;
+            break;
+        }
+        if (n == 0) { break; }
+        aes_ctr_xor_parallel(ctx, nonce, offset, chunk, n, threads);
+        if (write_full(out, chunk, n) != 0) { rc = AES_ERROR; }
+        offset += n;
+    }
+
+    free(chunk);
+    close(in);
+    if (close(out) != 0) { rc = AES_ERROR; }
+    return rc;
+}
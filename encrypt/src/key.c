@@ -1,5 +1,7 @@
 #include <string.h>
-#include "key.h"
+#include "aes.h"
+#include "aesni.h"
+#include "bitslice.h"
 
 extern const uint8_t sbox[256];
 extern void shift_row_n(uint8_t *row, uint8_t n);
@@ -12,7 +14,8 @@ void sub_word(uint8_t *word) {
     }
 }
 
-void key_expansion(const uint8_t *key, word* words) {
+// constant_time: SubWord through the bitsliced circuit instead of the sbox table
+static void key_expansion_portable(const uint8_t *key, word* words, int constant_time) {
     int i = 0;
     
     // First 4 bytes of the key are 4 words
@@ -26,7 +29,11 @@ void key_expansion(const uint8_t *key, word* words) {
         memcpy(temp, words[i-1], 4);
         if (i % Nk == 0) {
             shift_row_n(temp, 1);
-            sub_word(temp);
+            if (constant_time) {
+                bitslice_sub_word(temp);
+            } else {
+                sub_word(temp);
+            }
             temp[0] ^= round_constants[i/Nk];
         }
         words[i][0] = words[i - Nk][0] ^ temp[0];
@@ -35,4 +42,13 @@ void key_expansion(const uint8_t *key, word* words) {
         words[i][3] = words[i - Nk][3] ^ temp[3];
         i++;
     }
+}
+
+void key_expansion(const uint8_t *key, word* words) {
+    aes_backend_t backend = aes_get_backend();
+    if (backend == AES_BACKEND_AESNI) {
+        aesni_key_expansion(key, words);
+    } else {
+        key_expansion_portable(key, words, backend == AES_BACKEND_BITSLICE);
+    }
 }
\ No newline at end of file
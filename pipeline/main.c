@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#include "pipeline.h"
+#include "io.h"
+
+// Clave de 32 dígitos hexadecimales.
+static int parseKey(const char *hex, uint8_t key[PIPE_KEY_SIZE]) {
+    if (strlen(hex) != 2 * PIPE_KEY_SIZE) { return -1; }
+    for (int i = 0; i < PIPE_KEY_SIZE; i++) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+        if (!isxdigit((unsigned char)byte[0]) || !isxdigit((unsigned char)byte[1])) { return -1; }
+        key[i] = (uint8_t)strtoul(byte, NULL, 16);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    // hufcrypt -k clave [-j hilos] [-b bloque] [-l bits] [-z nivel] [-c] input output   comprime y cifra (HUFE)
+    // hufcrypt -d -k clave input output                                                  descifra y descomprime
+    // La clave son 32 dígitos hexadecimales (AES-128); las opciones de compresión son las de huffman.
+    int decrypt = 0;
+    const char *key_hex = NULL;
+    CompressOptions opts;
+    memset(&opts, 0, sizeof opts);
+    const char *paths[2] = {NULL, NULL};
+    int npaths = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0) {
+            decrypt = 1;
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            key_hex = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            opts.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            opts.block_size = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            opts.max_code_len = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-z") == 0 && i + 1 < argc) {
+            opts.level = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0) {
+            opts.context = 1;
+        } else if (npaths < 2) {
+            paths[npaths++] = argv[i];
+        } else {
+            npaths = 3;
+            break;
+        }
+    }
+
+    uint8_t key[PIPE_KEY_SIZE];
+    if (npaths != 2 || !key_hex || parseKey(key_hex, key) != 0) {
+        fprintf(stderr, "usage: %s [-d] -k key_hex [-j threads] [-b block_size] [-l max_code_len] [-z level] [-c] input output\n", argv[0]);
+        return 1;
+    }
+
+    if (decrypt) {
+        if (pipelineDecryptDecompress(paths[0], paths[1], key) != 0) {
+            fprintf(stderr, "Error decrypting %s.\n", paths[0]);
+            return 1;
+        }
+        return 0;
+    }
+
+    MappedFile in;
+    if (mapFile(paths[0], &in) != 0) {
+        perror("open");
+        return 1;
+    }
+    int rc = pipelineCompressEncrypt(in.data, in.size, paths[1], key, &opts);
+    unmapFile(&in);
+    if (rc != 0) {
+        fprintf(stderr, "Error writing %s.\n", paths[1]);
+        return 1;
+    }
+    return 0;
+}
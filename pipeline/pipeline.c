@@ -0,0 +1,173 @@
+#include "pipeline.h"
+#include "ring.h"
+#include "decompress.h"
+#include "io.h"
+#include "aes.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define PIPE_RING_PER_THREAD 2   // bloques en vuelo por hilo compresor
+
+// Etapa de cifrado: consume bloques del ring en orden, los cifra en su posición y los escribe.
+typedef struct EncryptStage {
+    Ring *ring;
+    int fd;
+    aes_ctx aes;
+    uint8_t nonce[PIPE_NONCE_SIZE];
+    uint64_t offset;         // posición del próximo bloque dentro del HUF2
+    uint64_t *index;
+    uint32_t block_count;
+    uint32_t written;
+    int error;
+} EncryptStage;
+
+static void *encryptWorker(void *arg) {
+    EncryptStage *st = arg;
+    RingSlot slot;
+    while (ringPop(st->ring, &slot) == 0) {
+        if (!st->error) {
+            aes_ctr_xor(&st->aes, st->nonce, st->offset, slot.data, slot.size);
+            struct iovec iov = {slot.data, slot.size};
+            if (st->written == st->block_count ||
+                pwritevAll(st->fd, &iov, 1, (off_t)(PIPE_HEADER_SIZE + st->offset)) != 0) {
+                st->error = 1;
+                ringFail(st->ring);
+            } else {
+                st->index[st->written++] = st->offset;
+                st->offset += slot.size;
+            }
+        }
+        free(slot.data);
+    }
+    return NULL;
+}
+
+// Comprime de a batch bloques (uno por hilo) y los entrega al ring en orden.
+static int produceBlocks(Ring *ring, const unsigned char *input, size_t input_size, const CompressOptions *opts,
+                         uint32_t block_count, uint32_t batch) {
+    unsigned char **blocks = malloc(batch * sizeof *blocks);
+    size_t *sizes = malloc(batch * sizeof *sizes);
+    int rc = (blocks && sizes) ? 0 : -1;
+    for (uint32_t first = 0; rc == 0 && first < block_count; first += batch) {
+        uint64_t pos = (uint64_t)first * opts->block_size;
+        size_t bytes = input_size - (size_t)pos < (size_t)batch * opts->block_size
+                     ? input_size - (size_t)pos : (size_t)batch * opts->block_size;
+        uint32_t n = (uint32_t)huf2BlockCount(bytes, opts->block_size);
+        rc = compressBlocks(input + pos, bytes, opts, blocks, sizes);
+        for (uint32_t b = 0; rc == 0 && b < n; b++) {
+            if (ringPush(ring, blocks[b], sizes[b]) != 0) {
+                for (uint32_t k = b; k < n; k++) { free(blocks[k]); }
+                rc = -1;
+            }
+        }
+    }
+    free(blocks);
+    free(sizes);
+    return rc;
+}
+
+static int randomNonce(uint8_t nonce[PIPE_NONCE_SIZE]) {
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    int rc = readAll(fd, nonce, PIPE_NONCE_SIZE);
+    close(fd);
+    return rc;
+}
+
+int pipelineCompressEncrypt(const unsigned char *input, size_t input_size, const char *output_path,
+                            const uint8_t key[PIPE_KEY_SIZE], const CompressOptions *opts) {
+    CompressOptions o;
+    memset(&o, 0, sizeof o);
+    if (opts) { o = *opts; }
+    if (o.block_size == 0) { o.block_size = HUF2_DEFAULT_BLOCK_SIZE; }
+    if (o.threads <= 0) { o.threads = defaultThreadCount(); }
+    uint64_t count = huf2BlockCount(input_size, o.block_size);
+    if (o.block_size > UINT32_MAX || count > UINT32_MAX - 1) { return -1; }
+    uint32_t block_count = (uint32_t)count;
+
+    EncryptStage st;
+    memset(&st, 0, sizeof st);
+    Ring ring;
+    size_t index_bytes = ((size_t)block_count + 1) * sizeof *st.index;
+    st.index = malloc(index_bytes);
+    if (!st.index || randomNonce(st.nonce) != 0 || ringInit(&ring, (uint32_t)o.threads * PIPE_RING_PER_THREAD) != 0) {
+        free(st.index);
+        return -1;
+    }
+    aes_ctx_init(&st.aes, key);
+    st.ring = &ring;
+    st.block_count = block_count;
+    st.offset = HUF2_HEADER_SIZE + index_bytes;
+
+    int rc = -1;
+    st.fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    pthread_t tid;
+    if (st.fd >= 0 && pthread_create(&tid, NULL, encryptWorker, &st) == 0) {
+        rc = produceBlocks(&ring, input, input_size, &o, block_count, (uint32_t)o.threads);
+        ringClose(&ring);
+        pthread_join(tid, NULL);
+        if (st.error || st.written != block_count) { rc = -1; }
+    }
+
+    // Cabecera e índice se conocen al final; se cifran en su posición (el inicio del HUF2).
+    if (rc == 0) {
+        st.index[block_count] = st.offset;
+        size_t head_size = HUF2_HEADER_SIZE + index_bytes;
+        unsigned char *head = malloc(PIPE_HEADER_SIZE + head_size);
+        rc = head ? 0 : -1;
+        if (head) {
+            memcpy(head, "HUFE", 4);
+            memcpy(head + 4, st.nonce, PIPE_NONCE_SIZE);
+            huf2Header(head + PIPE_HEADER_SIZE, (uint64_t)input_size, (uint32_t)o.block_size, block_count);
+            memcpy(head + PIPE_HEADER_SIZE + HUF2_HEADER_SIZE, st.index, index_bytes);
+            aes_ctr_xor(&st.aes, st.nonce, 0, head + PIPE_HEADER_SIZE, head_size);
+            struct iovec iov = {head, PIPE_HEADER_SIZE + head_size};
+            rc = pwritevAll(st.fd, &iov, 1, 0);
+            free(head);
+        }
+    }
+    if (st.fd >= 0 && close(st.fd) != 0) { rc = -1; }
+    ringFree(&ring);
+    free(st.index);
+    aes_ctx_clear(&st.aes);
+    return rc;
+}
+
+int pipelineDecryptDecompress(const char *input_path, const char *output_path, const uint8_t key[PIPE_KEY_SIZE]) {
+    MappedFile in;
+    if (mapFile(input_path, &in) != 0) {
+        return -1;
+    }
+    if (in.size < PIPE_HEADER_SIZE || memcmp(in.data, "HUFE", 4) != 0) {
+        unmapFile(&in);
+        return -1;
+    }
+
+    size_t size = in.size - PIPE_HEADER_SIZE;
+    unsigned char *plain = malloc(size ? size : 1);
+    if (!plain) {
+        unmapFile(&in);
+        return -1;
+    }
+    aes_ctx aes;
+    aes_ctx_init(&aes, key);
+    memcpy(plain, in.data + PIPE_HEADER_SIZE, size);
+    aes_ctr_xor_parallel(&aes, in.data + 4, 0, plain, size, 0);
+    aes_ctx_clear(&aes);
+    unmapFile(&in);
+
+    unsigned char *out;
+    size_t out_size;
+    int rc = decompressBuffer(plain, size, &out, &out_size);
+    free(plain);
+    if (rc == 0) {
+        rc = writeFile(output_path, out, out_size);
+        free(out);
+    }
+    return rc;
+}
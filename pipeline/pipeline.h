@@ -0,0 +1,31 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "parallel.h"
+#include "ctr.h"
+
+// Compress-then-encrypt in one pass, with no intermediate file.
+// The compressing thread(s) produce HUF2 blocks and push them through a bounded ring
+// (ring.h) to an encrypting thread, which applies AES-128-CTR at each block's position
+// and writes it out. Memory stays bounded by the ring and one batch of blocks.
+// File: "HUFE" | nonce u8[8] | AES-128-CTR(HUF2 container)
+// CTR counter block: nonce | big-endian u64 index of the 16-byte block within the container
+// (the layout of aes_ctr_xor, see ctr.h)
+
+#define PIPE_NONCE_SIZE CTR_NONCE_SIZE
+#define PIPE_HEADER_SIZE (4 + PIPE_NONCE_SIZE)
+#define PIPE_KEY_SIZE 16
+
+// Compresses input as HUF2 and writes it encrypted to output_path
+// opts: compression options, or NULL for the defaults (threads also sizes the ring)
+// Returns: 0 on success, -1 on error
+int pipelineCompressEncrypt(const unsigned char *input, size_t input_size, const char *output_path,
+                            const uint8_t key[PIPE_KEY_SIZE], const CompressOptions *opts);
+
+// Decrypts and decompresses a file written by pipelineCompressEncrypt
+// Returns: 0 on success, -1 on error (including a wrong key, seen as a corrupt container)
+int pipelineDecryptDecompress(const char *input_path, const char *output_path, const uint8_t key[PIPE_KEY_SIZE]);
+
+#endif // PIPELINE_H
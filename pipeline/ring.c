@@ -0,0 +1,72 @@
+#define _POSIX_C_SOURCE 200809L   // sched_yield con -std=c11
+#include "ring.h"
+#include <sched.h>
+#include <stdlib.h>
+
+#define RING_SPINS 64   // vueltas de espera activa antes de ceder la CPU
+
+static void ringWait(unsigned *spins) {
+    if (++*spins >= RING_SPINS) {
+        sched_yield();
+        *spins = 0;
+    }
+}
+
+int ringInit(Ring *r, uint32_t capacity) {
+    uint64_t n = 1;
+    while (n < capacity) { n <<= 1; }
+    r->slots = malloc(n * sizeof *r->slots);
+    if (!r->slots) {
+        return -1;
+    }
+    r->mask = n - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->closed, 0);
+    atomic_init(&r->failed, 0);
+    return 0;
+}
+
+void ringFree(Ring *r) {
+    free(r->slots);
+    r->slots = NULL;
+}
+
+int ringPush(Ring *r, unsigned char *data, size_t size) {
+    // Solo el productor escribe tail: se lee relajado; head con acquire para ver el slot libre.
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    unsigned spins = 0;
+    while (tail - atomic_load_explicit(&r->head, memory_order_acquire) > r->mask) {
+        if (atomic_load_explicit(&r->failed, memory_order_relaxed)) { return -1; }
+        ringWait(&spins);
+    }
+    if (atomic_load_explicit(&r->failed, memory_order_relaxed)) { return -1; }
+
+    r->slots[tail & r->mask].data = data;
+    r->slots[tail & r->mask].size = size;
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+int ringPop(Ring *r, RingSlot *slot) {
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned spins = 0;
+    while (atomic_load_explicit(&r->tail, memory_order_acquire) == head) {
+        // closed se publica después del último push: si está y tail no avanzó, no queda nada.
+        if (atomic_load_explicit(&r->closed, memory_order_acquire) &&
+            atomic_load_explicit(&r->tail, memory_order_acquire) == head) { return 1; }
+        ringWait(&spins);
+    }
+
+    *slot = r->slots[head & r->mask];
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return 0;
+}
+
+void ringClose(Ring *r) {
+    atomic_store_explicit(&r->closed, 1, memory_order_release);
+}
+
+void ringFail(Ring *r) {
+    atomic_store_explicit(&r->failed, 1, memory_order_relaxed);
+}
@@ -0,0 +1,47 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Bounded single-producer / single-consumer queue of buffers between two threads.
+// Head and tail are atomics on separate cache lines, so neither side takes a lock; a side
+// that finds the ring full (or empty) spins briefly and then yields the CPU.
+
+typedef struct RingSlot {
+    unsigned char *data;
+    size_t size;
+} RingSlot;
+
+typedef struct Ring {
+    RingSlot *slots;
+    uint64_t mask;                              // capacity - 1 (capacity is a power of 2)
+    _Alignas(64) atomic_uint_fast64_t head;     // next slot to pop, written by the consumer
+    _Alignas(64) atomic_uint_fast64_t tail;     // next slot to push, written by the producer
+    _Alignas(64) atomic_int closed;             // the producer pushes nothing more
+    atomic_int failed;                          // the consumer gave up: pushes are refused
+} Ring;
+
+// Allocates a ring of at least capacity slots (rounded up to a power of 2)
+// Returns: 0 on success, -1 on error
+int ringInit(Ring *r, uint32_t capacity);
+
+// Releases the slots; buffers still queued are not freed
+void ringFree(Ring *r);
+
+// Queues a buffer, waiting while the ring is full (producer only)
+// Returns: 0 on success, -1 if the consumer failed (the buffer was not queued)
+int ringPush(Ring *r, unsigned char *data, size_t size);
+
+// Takes the oldest buffer, waiting while the ring is empty (consumer only)
+// Returns: 0 with a buffer in slot, 1 once the ring is closed and drained
+int ringPop(Ring *r, RingSlot *slot);
+
+// Marks the end of the stream (producer only)
+void ringClose(Ring *r);
+
+// Makes every later ringPush fail (consumer only); the consumer keeps popping until closed
+void ringFail(Ring *r);
+
+#endif // RING_H